@@ -3,6 +3,10 @@
 #include "certificate.hpp"
 
 #include <CLI/CLI.hpp>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <utility>
 
 namespace phosphor::certs
 {
@@ -10,16 +14,31 @@ namespace phosphor::certs
 int processArguments(int argc, const char* const* argv, Arguments& arguments)
 {
     CLI::App app{"OpenBMC Certificate Management Daemon"};
-    app.add_option("-t,--type", arguments.typeStr, "certificate type")
-        ->required();
-    app.add_option("-e,--endpoint", arguments.endpoint, "d-bus endpoint")
-        ->required();
-    app.add_option("-p,--path", arguments.path, "certificate file path")
-        ->required();
+    auto typeOpt =
+        app.add_option("-t,--type", arguments.typeStr, "certificate type");
+    auto endpointOpt =
+        app.add_option("-e,--endpoint", arguments.endpoint, "d-bus endpoint");
+    auto pathOpt =
+        app.add_option("-p,--path", arguments.path, "certificate file path");
     app.add_option("-u,--unit", arguments.unit,
                    "Optional systemd unit need to reload")
         ->capture_default_str();
+    app.add_option("-c,--config", arguments.config,
+                   "File listing several endpoints to host instead")
+        ->excludes(typeOpt)
+        ->excludes(endpointOpt)
+        ->excludes(pathOpt);
     CLI11_PARSE(app, argc, argv);
+    if (!arguments.config.empty())
+    {
+        return 0;
+    }
+    if (arguments.endpoint.empty() || arguments.path.empty())
+    {
+        std::cerr << "endpoint and path are required without a config."
+                  << std::endl;
+        return 1;
+    }
     phosphor::certs::CertificateType type =
         phosphor::certs::stringToCertificateType(arguments.typeStr);
     if (type == phosphor::certs::CertificateType::unsupported)
@@ -29,4 +48,48 @@ int processArguments(int argc, const char* const* argv, Arguments& arguments)
     }
     return 0;
 }
+
+int processConfig(std::istream& config, std::vector<Arguments>& endpoints)
+{
+    std::set<std::pair<std::string, std::string>> hosted;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(config, line); ++lineNumber)
+    {
+        std::istringstream fields(line);
+        Arguments endpoint;
+        if (!(fields >> endpoint.typeStr) || endpoint.typeStr.front() == '#')
+        {
+            continue;
+        }
+        std::string extra;
+        if (!(fields >> endpoint.endpoint >> endpoint.path) ||
+            (fields >> endpoint.unit && fields >> extra))
+        {
+            std::cerr << "config line " << lineNumber
+                      << ": expected <type> <endpoint> <path> [<unit>]."
+                      << std::endl;
+            return 1;
+        }
+        if (stringToCertificateType(endpoint.typeStr) ==
+            CertificateType::unsupported)
+        {
+            std::cerr << "config line " << lineNumber
+                      << ": type invalid." << std::endl;
+            return 1;
+        }
+        if (!hosted.emplace(endpoint.typeStr, endpoint.endpoint).second)
+        {
+            std::cerr << "config line " << lineNumber
+                      << ": endpoint listed twice." << std::endl;
+            return 1;
+        }
+        endpoints.push_back(std::move(endpoint));
+    }
+    if (endpoints.empty())
+    {
+        std::cerr << "config lists no endpoint." << std::endl;
+        return 1;
+    }
+    return 0;
+}
 } // namespace phosphor::certs
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <istream>
 #include <string>
+#include <vector>
 
 namespace phosphor::certs
 {
@@ -11,9 +13,15 @@ struct Arguments
     std::string endpoint; // d-bus endpoint
     std::string path;     // certificate file path
     std::string unit;     // Optional systemd unit need to reload
+    std::string config;   // Optional file listing several endpoints to host
 };
 
 // Validates all |argv| is valid and set corresponding attributes in
 // |arguments|.
 int processArguments(int argc, const char* const* argv, Arguments& arguments);
+
+// Reads the endpoints a single process hosts from |config|: one per line, as
+// "<type> <endpoint> <path> [<unit>]"; empty lines and lines starting with
+// '#' are skipped. Validates them and appends them to |endpoints|.
+int processConfig(std::istream& config, std::vector<Arguments>& endpoints);
 } // namespace phosphor::certs
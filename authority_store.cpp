@@ -0,0 +1,160 @@
+#include "config.h"
+
+#include "authority_store.hpp"
+
+#include <openssl/err.h>
+
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+} // namespace
+
+AuthorityStore::AuthorityStore() : enabled(sharedAuthorityStore)
+{}
+
+AuthorityStore& AuthorityStore::getInstance()
+{
+    static AuthorityStore instance;
+    return instance;
+}
+
+std::shared_ptr<X509_STORE> AuthorityStore::newStore()
+{
+    std::shared_ptr<X509_STORE> newStore(X509_STORE_new(), ::X509_STORE_free);
+    if (!newStore)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_new call");
+        elog<InternalFailure>();
+    }
+    return newStore;
+}
+
+void AuthorityStore::add(const std::string& fingerprint, X509& cert)
+{
+    std::lock_guard lock(mutex);
+    auto authority = authorities.find(fingerprint);
+    if (authority != authorities.end())
+    {
+        ++authority->second.second;
+        return;
+    }
+
+    if (!store)
+    {
+        store = newStore();
+    }
+    // The store takes its own reference of the certificate
+    if (X509_STORE_add_cert(store.get(), &cert) != 1)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_add_cert call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+    X509_up_ref(&cert);
+    authorities.emplace(fingerprint,
+                        std::make_pair(X509Ptr(&cert, ::X509_free), 1));
+}
+
+void AuthorityStore::remove(const std::vector<std::string>& fingerprints)
+{
+    std::lock_guard lock(mutex);
+    // Nothing changes until the new store is built, so a failure leaves the
+    // authorities and their store as they were
+    std::map<std::string, size_t> removals;
+    for (const auto& fingerprint : fingerprints)
+    {
+        if (authorities.contains(fingerprint))
+        {
+            ++removals[fingerprint];
+        }
+    }
+    auto isDropped = [&removals](const std::string& fingerprint,
+                                 size_t count) {
+        auto removal = removals.find(fingerprint);
+        return removal != removals.end() && count <= removal->second;
+    };
+    bool removed = false;
+    for (const auto& [fingerprint, authority] : authorities)
+    {
+        removed = removed || isDropped(fingerprint, authority.second);
+    }
+
+    // Null once the last authority is dropped
+    std::shared_ptr<X509_STORE> rebuilt;
+    for (const auto& [fingerprint, authority] : authorities)
+    {
+        if (!removed || isDropped(fingerprint, authority.second))
+        {
+            continue;
+        }
+        if (!rebuilt)
+        {
+            rebuilt = newStore();
+        }
+        if (X509_STORE_add_cert(rebuilt.get(), authority.first.get()) != 1)
+        {
+            log<level::ERR>("Error occurred during X509_STORE_add_cert call",
+                            entry("ERRCODE=%lu", ERR_get_error()));
+            elog<InternalFailure>();
+        }
+    }
+
+    // Commit the authorities together with their store
+    for (auto it = authorities.begin(); it != authorities.end();)
+    {
+        auto removal = removals.find(it->first);
+        if (removal == removals.end())
+        {
+            ++it;
+        }
+        else if (it->second.second <= removal->second)
+        {
+            it = authorities.erase(it);
+        }
+        else
+        {
+            it->second.second -= removal->second;
+            ++it;
+        }
+    }
+    if (removed)
+    {
+        store = std::move(rebuilt);
+    }
+}
+
+std::shared_ptr<X509_STORE> AuthorityStore::get() const
+{
+    std::lock_guard lock(mutex);
+    return store;
+}
+
+size_t AuthorityStore::size() const
+{
+    std::lock_guard lock(mutex);
+    return authorities.size();
+}
+
+bool AuthorityStore::isEnabled() const
+{
+    return enabled;
+}
+
+void AuthorityStore::setEnabled(bool value)
+{
+    enabled = value;
+}
+
+} // namespace phosphor::certs
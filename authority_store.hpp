@@ -0,0 +1,90 @@
+#pragma once
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @class AuthorityStore
+ *
+ *  @brief In-memory store of the authorities installed in the process
+ *
+ *  The authority managers of the process share their certificates here, so
+ *  the server and client certificates get their chain validated against the
+ *  installed authorities without building a store per install. Additions
+ *  extend the store in place; removals build a new one, since an X509_STORE
+ *  can't drop certificates, while the validations still holding the former
+ *  one carry on with it. A certificate installed by several managers stays
+ *  until all of them removed it. Safe to use from any thread.
+ */
+class AuthorityStore
+{
+  public:
+    using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
+
+    AuthorityStore();
+    AuthorityStore(const AuthorityStore&) = delete;
+    AuthorityStore& operator=(const AuthorityStore&) = delete;
+    AuthorityStore(AuthorityStore&&) = delete;
+    AuthorityStore& operator=(AuthorityStore&&) = delete;
+
+    /** @brief Get the store shared by the managers of the process */
+    static AuthorityStore& getInstance();
+
+    /** @brief Add an authority
+     *  @param[in] fingerprint - SHA-256 fingerprint of the certificate.
+     *  @param[in] cert - The certificate; the store takes a reference.
+     */
+    void add(const std::string& fingerprint, X509& cert);
+
+    /** @brief Remove authorities, building the store again at most once;
+     *  the store is left as it was if building it fails
+     *  @param[in] fingerprints - SHA-256 fingerprints of the certificates.
+     */
+    void remove(const std::vector<std::string>& fingerprints);
+
+    /** @brief Get the current store to validate against; null if there is
+     *  no authority
+     */
+    std::shared_ptr<X509_STORE> get() const;
+
+    /** @brief Number of distinct authorities in the store */
+    size_t size() const;
+
+    /** @brief Whether the chains are validated against the store; set by
+     *  the 'shared-authority-store' option, switched at runtime by tests
+     */
+    bool isEnabled() const;
+
+    /** @brief Enable or disable the validation against the store
+     *  @param[in] value - true to enable.
+     */
+    void setEnabled(bool value);
+
+  private:
+    /** @brief Create an empty store */
+    static std::shared_ptr<X509_STORE> newStore();
+
+    /** @brief Guards the members; validations run on worker threads */
+    mutable std::mutex mutex;
+
+    /** @brief Authorities and the number of times they were added, by
+     * fingerprint */
+    std::map<std::string, std::pair<X509Ptr, size_t>> authorities;
+
+    /** @brief Store of |authorities|; null while there are none */
+    std::shared_ptr<X509_STORE> store;
+
+    /** @brief Whether the chains are validated against the store */
+    std::atomic<bool> enabled;
+};
+
+} // namespace phosphor::certs
@@ -0,0 +1,542 @@
+#include "config.h"
+
+#include "certificate.hpp"
+#include "certs_manager.hpp"
+#include "file_utils.hpp"
+#include "x509_utils.hpp"
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <systemd/sd-event.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <new>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <sdeventplus/event.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Every allocation, of the operator new and of OpenSSL, is counted so that
+// the benchmarks report the peak memory use alongside the time; the JSON
+// output (--benchmark_format=json) carries it as allocs_per_iter and
+// max_bytes_used
+namespace
+{
+
+class AllocationCounter
+{
+  public:
+    void allocated(size_t size)
+    {
+        ++numAllocs;
+        totalBytes += size;
+        size_t now = currentBytes += size;
+        size_t peak = peakBytes.load();
+        while (now > peak && !peakBytes.compare_exchange_weak(peak, now))
+        {}
+    }
+
+    void freed(size_t size)
+    {
+        currentBytes -= size;
+    }
+
+    void start()
+    {
+        baseBytes = currentBytes.load();
+        peakBytes = baseBytes;
+        numAllocs = 0;
+        totalBytes = 0;
+    }
+
+    void stop(benchmark::MemoryManager::Result& result) const
+    {
+        result.num_allocs = static_cast<int64_t>(numAllocs.load());
+        result.max_bytes_used = static_cast<int64_t>(peakBytes - baseBytes);
+        result.total_allocated_bytes = static_cast<int64_t>(totalBytes.load());
+        result.net_heap_growth =
+            static_cast<int64_t>(currentBytes.load() - baseBytes);
+    }
+
+  private:
+    std::atomic<size_t> numAllocs = 0;
+    std::atomic<size_t> totalBytes = 0;
+    std::atomic<size_t> currentBytes = 0;
+    std::atomic<size_t> peakBytes = 0;
+    size_t baseBytes = 0;
+};
+
+AllocationCounter allocationCounter;
+
+// The size of each block lives in front of it, keeping the alignment of
+// malloc()
+void* trackedMalloc(size_t size)
+{
+    auto block = static_cast<std::max_align_t*>(
+        std::malloc(size + sizeof(std::max_align_t)));
+    if (block == nullptr)
+    {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    allocationCounter.allocated(size);
+    return block + 1;
+}
+
+void trackedFree(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    auto block = static_cast<std::max_align_t*>(ptr) - 1;
+    allocationCounter.freed(*reinterpret_cast<size_t*>(block));
+    std::free(block);
+}
+
+void* trackedRealloc(void* ptr, size_t size)
+{
+    if (ptr == nullptr)
+    {
+        return trackedMalloc(size);
+    }
+    if (size == 0)
+    {
+        trackedFree(ptr);
+        return nullptr;
+    }
+    auto block = static_cast<std::max_align_t*>(ptr) - 1;
+    size_t oldSize = *reinterpret_cast<size_t*>(block);
+    auto newBlock = static_cast<std::max_align_t*>(
+        std::realloc(block, size + sizeof(std::max_align_t)));
+    if (newBlock == nullptr)
+    {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(newBlock) = size;
+    allocationCounter.freed(oldSize);
+    allocationCounter.allocated(size);
+    return newBlock + 1;
+}
+
+void* cryptoMalloc(size_t size, const char*, int)
+{
+    return trackedMalloc(size);
+}
+
+void* cryptoRealloc(void* ptr, size_t size, const char*, int)
+{
+    return trackedRealloc(ptr, size);
+}
+
+void cryptoFree(void* ptr, const char*, int)
+{
+    trackedFree(ptr);
+}
+
+class CountingMemoryManager : public benchmark::MemoryManager
+{
+  public:
+    void Start() override
+    {
+        allocationCounter.start();
+    }
+
+    // google-benchmark takes the result by pointer until 1.8 and by
+    // reference from 1.7; meson tells which of them the installed one has
+#if BENCHMARK_STOP_BY_POINTER
+    void Stop(Result* result) override
+    {
+        allocationCounter.stop(*result);
+    }
+#endif
+
+#if BENCHMARK_STOP_BY_REFERENCE
+    void Stop(Result& result) override
+    {
+        allocationCounter.stop(result);
+    }
+#endif
+};
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    void* ptr = trackedMalloc(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedMalloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedMalloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    trackedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    trackedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    trackedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    trackedFree(ptr);
+}
+
+namespace phosphor::certs
+{
+namespace
+{
+namespace fs = std::filesystem;
+using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
+using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
+using BIOMemPtr = std::unique_ptr<BIO, decltype(&::BIO_free)>;
+
+constexpr auto unitToRestart = "xyz.openbmc_project.awesome-service";
+
+/** @brief Manager not reloading any unit, as the one of the unit tests */
+class ManagerInBenchmark : public Manager
+{
+  public:
+    using Manager::generateCSRHelper;
+    using Manager::Manager;
+
+    ~ManagerInBenchmark() override
+    {
+        flushReload();
+    }
+
+    void reloadOrReset(const std::string&) override {}
+};
+
+/** @brief Directory removed with everything in it when going away */
+struct TempDirectory
+{
+    TempDirectory() : path(createUniqueDirectory(fs::temp_directory_path())) {}
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+    ~TempDirectory()
+    {
+        fs::remove_all(path);
+    }
+
+    fs::path path;
+};
+
+sdbusplus::bus_t& getBus()
+{
+    static sdbusplus::bus_t bus = []() {
+        auto bus = sdbusplus::bus::new_default();
+        bus.attach_event(sdeventplus::Event::get_default().get(),
+                         SD_EVENT_PRIORITY_NORMAL);
+        return bus;
+    }();
+    return bus;
+}
+
+sdeventplus::Event& getEvent()
+{
+    static sdeventplus::Event event = sdeventplus::Event::get_default();
+    return event;
+}
+
+std::string getObjectPath(CertificateType type)
+{
+    return std::string(objectNamePrefix) + '/' +
+           certificateTypeToString(type) + "/benchmark";
+}
+
+// Self-signed root certificate, signed with a P-256 key to keep the
+// generation of the large bundles quick
+X509Ptr createRootCertificate(EVP_PKEY& key, size_t serial)
+{
+    X509Ptr cert(X509_new(), ::X509_free);
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()),
+                     static_cast<long>(serial));
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 365L * 24 * 3600 * 100);
+    X509_set_pubkey(cert.get(), &key);
+
+    std::string cn = "root_" + std::to_string(serial);
+    X509_NAME* name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(
+        name, "O", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>("openbmc-project.xyz"), -1, -1,
+        0);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>(cn.c_str()), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+
+    X509V3_CTX ctx;
+    X509V3_set_ctx(&ctx, cert.get(), cert.get(), nullptr, nullptr, 0);
+    for (auto [nid, value] :
+         {std::pair{NID_basic_constraints, "critical,CA:TRUE"},
+          std::pair{NID_key_usage, "critical,keyCertSign,cRLSign"},
+          std::pair{NID_subject_key_identifier, "hash"}})
+    {
+        X509_EXTENSION* ext =
+            X509V3_EXT_conf_nid(nullptr, &ctx, nid, value);
+        X509_add_ext(cert.get(), ext, -1);
+        X509_EXTENSION_free(ext);
+    }
+    X509_sign(cert.get(), &key, EVP_sha256());
+    return cert;
+}
+
+/** @brief PEM encoded authorities list of |count| root certificates */
+const std::string& getBundle(size_t count)
+{
+    static std::map<size_t, std::string> bundles;
+    if (auto bundle = bundles.find(count); bundle != bundles.end())
+    {
+        return bundle->second;
+    }
+
+    EVPPkeyPtr key(EVP_EC_gen("P-256"), ::EVP_PKEY_free);
+    BIOMemPtr bio(BIO_new(BIO_s_mem()), ::BIO_free);
+    for (size_t i = 0; i < count; ++i)
+    {
+        X509Ptr cert = createRootCertificate(*key, i + 1);
+        PEM_write_bio_X509(bio.get(), cert.get());
+    }
+    char* data = nullptr;
+    long size = BIO_get_mem_data(bio.get(), &data);
+    return bundles
+        .emplace(count, std::string(data, static_cast<size_t>(size)))
+        .first->second;
+}
+
+/** @brief PEM encoded server certificate along with its private key */
+std::string getServerPem()
+{
+    EVPPkeyPtr key(EVP_EC_gen("P-256"), ::EVP_PKEY_free);
+    X509Ptr cert = createRootCertificate(*key, 1);
+    BIOMemPtr bio(BIO_new(BIO_s_mem()), ::BIO_free);
+    PEM_write_bio_PrivateKey(bio.get(), key.get(), nullptr, nullptr, 0, nullptr,
+                             nullptr);
+    PEM_write_bio_X509(bio.get(), cert.get());
+    char* data = nullptr;
+    long size = BIO_get_mem_data(bio.get(), &data);
+    return std::string(data, static_cast<size_t>(size));
+}
+
+/** @brief Write the authorities list of |count| certificates to |dir| */
+std::string writeBundle(const fs::path& dir, size_t count)
+{
+    std::string path = dir / "bundle.pem";
+    writeFileAtomically(path, getBundle(count));
+    return path;
+}
+
+void allBundleSizes(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t count : {1, 10, 100, 1000})
+    {
+        bench->Arg(count);
+    }
+}
+
+/** @brief Skip the bundles InstallAll would refuse; raise the
+ *  authority-limit option to benchmark them
+ *  @return true if the benchmark got skipped
+ */
+bool skipAboveAuthorityLimit(benchmark::State& state)
+{
+    if (static_cast<size_t>(state.range(0)) <= maxNumAuthorityCertificates)
+    {
+        return false;
+    }
+    state.SkipWithError("Bundle exceeds the authority-limit option");
+    return true;
+}
+
+void splitCertificatesBenchmark(benchmark::State& state)
+{
+    const std::string& bundle = getBundle(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(splitCertificates(bundle));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(splitCertificatesBenchmark)->Apply(allBundleSizes);
+
+void getX509StoreBenchmark(benchmark::State& state)
+{
+    TempDirectory dir;
+    std::string bundlePath =
+        writeBundle(dir.path, static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getX509Store(bundlePath));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(getX509StoreBenchmark)->Apply(allBundleSizes);
+
+void validateCertificateAgainstStoreBenchmark(benchmark::State& state)
+{
+    std::vector<X509Ptr> certs =
+        parseCerts(getBundle(static_cast<size_t>(state.range(0))));
+    auto store = getX509Store(certs);
+    for (auto _ : state)
+    {
+        validateCertificateAgainstStore(*store, *certs.back());
+    }
+}
+BENCHMARK(validateCertificateAgainstStoreBenchmark)->Apply(allBundleSizes);
+
+void populatePropertiesBenchmark(benchmark::State& state)
+{
+    TempDirectory srcDir;
+    TempDirectory installDir;
+    ManagerInBenchmark manager(
+        getBus(), getEvent(), getObjectPath(CertificateType::server).c_str(),
+        CertificateType::server, unitToRestart,
+        installDir.path / "server.pem");
+    std::string pemPath = srcDir.path / "server.pem";
+    writeFileAtomically(pemPath, getServerPem());
+    manager.install(pemPath);
+    // With the async-install option the install completes on the event loop
+    while (manager.getCertificates().empty())
+    {
+        getEvent().run(std::nullopt);
+    }
+    Certificate& cert = *manager.getCertificates().front();
+    for (auto _ : state)
+    {
+        cert.populateProperties();
+    }
+}
+BENCHMARK(populatePropertiesBenchmark);
+
+void installAllBenchmark(benchmark::State& state)
+{
+    if (skipAboveAuthorityLimit(state))
+    {
+        return;
+    }
+    TempDirectory srcDir;
+    TempDirectory installDir;
+    std::string bundlePath =
+        writeBundle(srcDir.path, static_cast<size_t>(state.range(0)));
+    std::string objPath = getObjectPath(CertificateType::authority);
+    ManagerInBenchmark manager(getBus(), getEvent(), objPath.c_str(),
+                               CertificateType::authority, unitToRestart,
+                               installDir.path);
+    for (auto _ : state)
+    {
+        manager.installAll(bundlePath);
+        state.PauseTiming();
+        manager.deleteAll();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(installAllBenchmark)->Apply(allBundleSizes);
+
+void replaceAllBenchmark(benchmark::State& state)
+{
+    if (skipAboveAuthorityLimit(state))
+    {
+        return;
+    }
+    TempDirectory srcDir;
+    TempDirectory installDir;
+    std::string bundlePath =
+        writeBundle(srcDir.path, static_cast<size_t>(state.range(0)));
+    std::string objPath = getObjectPath(CertificateType::authority);
+    ManagerInBenchmark manager(getBus(), getEvent(), objPath.c_str(),
+                               CertificateType::authority, unitToRestart,
+                               installDir.path);
+    manager.installAll(bundlePath);
+    for (auto _ : state)
+    {
+        manager.replaceAll(bundlePath);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(replaceAllBenchmark)->Apply(allBundleSizes);
+
+void generateCSRBenchmark(benchmark::State& state,
+                          std::string keyPairAlgorithm, std::string keyCurveId)
+{
+    TempDirectory installDir;
+    ManagerInBenchmark manager(
+        getBus(), getEvent(), getObjectPath(CertificateType::server).c_str(),
+        CertificateType::server, unitToRestart,
+        installDir.path / "server.pem");
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(manager.generateCSRHelper(
+            0, EVPPkeyPtr(nullptr, ::EVP_PKEY_free), {"localhost"}, "",
+            "Austin", "www.openbmc-project.xyz", "", "US", "", "", "", 2048,
+            keyCurveId, keyPairAlgorithm, {"serverAuth"}, "openbmc-project",
+            "BMC", "TX", "", ""));
+    }
+}
+BENCHMARK_CAPTURE(generateCSRBenchmark, RSA, "RSA", "");
+BENCHMARK_CAPTURE(generateCSRBenchmark, EC, "EC", "prime256v1");
+
+} // namespace
+} // namespace phosphor::certs
+
+int main(int argc, char** argv)
+{
+    // OpenSSL only takes them before its first allocation
+    if (CRYPTO_set_mem_functions(cryptoMalloc, cryptoRealloc, cryptoFree) == 0)
+    {
+        std::fprintf(stderr, "OpenSSL allocations are not counted\n");
+    }
+    CountingMemoryManager memoryManager;
+    benchmark::RegisterMemoryManager(&memoryManager);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include <acf_manager.hpp>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
@@ -18,8 +20,6 @@ using InvalidCertificate =
 
 using Reason = xyz::openbmc_project::Certs::InvalidCertificate::REASON;
 
-constexpr auto ACF_FILE_PATH = "/etc/acf/service.acf";
-
 /** @brief Implementation for readBinaryFile
  *  Read file contents into buffer
  *
@@ -63,10 +63,10 @@ static bool readBinaryFile(const std::string fileNameParm,
     return true;
 }
 
-bool acfInstalled()
+bool ACFCertMgr::acfInstalled() const
 {
     std::error_code ec;
-    std::filesystem::path path = ACF_FILE_PATH;
+    std::filesystem::path path = acfFilePath;
     bool exists = std::filesystem::exists(path, ec);
     if (ec)
     {
@@ -75,22 +75,64 @@ bool acfInstalled()
     return exists;
 }
 
+ACFCertMgr::ACFCertMgr(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
+                       const char* path, std::string acfFilePath) :
+    CreateIface(bus, path),
+    bus(bus), event(event), objectPath(path),
+    acfFilePath(std::move(acfFilePath)), lastEntryId(0)
+{
+    acfWatch = std::make_unique<phosphor::certs::Watch>(
+        event, this->acfFilePath, [this]() { cachedInfo.reset(); });
+}
+
+void ACFCertMgr::cacheInfo(const acf_info& info)
+{
+    using namespace std::chrono;
+    cachedInfo = info;
+    // Expiration dates have a day's resolution
+    cacheExpiry = floor<days>(now()) + days(1);
+}
+
+int ACFCertMgr::verifyACF(std::vector<uint8_t>& accessControlFile,
+                          std::string& date)
+{
+    Tacf tacf{[](std::string msg) {
+        log<phosphor::logging::level::INFO>(msg.c_str());
+    }};
+    return tacf.verify(accessControlFile.data(), accessControlFile.size(),
+                       date);
+}
+
+int ACFCertMgr::writeACF(std::vector<uint8_t>& accessControlFile,
+                         std::string& date)
+{
+    Tacf tacf{[](std::string msg) {
+        log<phosphor::logging::level::INFO>(msg.c_str());
+    }};
+    return tacf.install(accessControlFile.data(), accessControlFile.size(),
+                        date);
+}
+
+std::chrono::system_clock::time_point ACFCertMgr::now() const
+{
+    return std::chrono::system_clock::now();
+}
+
 acf_info ACFCertMgr::installACF(std::vector<uint8_t> accessControlFile)
 {
     std::string sDate;
+    // The cache gets updated below rather than by the watch
+    auto suppression = acfWatch->suppress();
+    cachedInfo.reset();
 
     // delete acf file if accessControlFile is empty
     if (accessControlFile.empty() && acfInstalled())
     {
-        std::remove(ACF_FILE_PATH);
+        std::remove(acfFilePath.c_str());
         return std::make_tuple(accessControlFile, acfInstalled(), sDate);
     }
     // Verify and install ACF and get expiration date.
-    Tacf tacf{[](std::string msg) {
-        log<phosphor::logging::level::INFO>(msg.c_str());
-    }};
-    int rc =
-        tacf.install(accessControlFile.data(), accessControlFile.size(), sDate);
+    int rc = writeACF(accessControlFile, sDate);
     if (rc)
     {
         log<level::INFO>("ACF install failed");
@@ -98,26 +140,30 @@ acf_info ACFCertMgr::installACF(std::vector<uint8_t> accessControlFile)
         elog<InvalidCertificate>(Reason("ACF validation failed"));
     }
 
-    return std::make_tuple(accessControlFile, acfInstalled(), sDate);
+    cacheInfo(std::make_tuple(accessControlFile, acfInstalled(), sDate));
+    return *cachedInfo;
 }
 
 std::tuple<std::vector<uint8_t>, bool, std::string> ACFCertMgr::getACFInfo(void)
 {
+    // Deletions don't reach the watch; checking costs a stat only
+    if (cachedInfo && now() < cacheExpiry &&
+        std::get<bool>(*cachedInfo) == acfInstalled())
+    {
+        return *cachedInfo;
+    }
+
     std::string sDate;
     std::vector<uint8_t> accessControlFile;
 
-    if (!readBinaryFile(ACF_FILE_PATH, accessControlFile))
+    if (!readBinaryFile(acfFilePath, accessControlFile))
     {
         log<level::ERR>("ACF not installed or not readable");
     }
     else
     {
         // Verify ACF and get expiration date.
-        Tacf tacf{[](std::string msg) {
-            log<phosphor::logging::level::INFO>(msg.c_str());
-        }};
-        int rc = tacf.verify(accessControlFile.data(), accessControlFile.size(),
-                             sDate);
+        int rc = verifyACF(accessControlFile, sDate);
         if (rc)
         {
             log<level::INFO>("ACF is not valid");
@@ -127,7 +173,8 @@ std::tuple<std::vector<uint8_t>, bool, std::string> ACFCertMgr::getACFInfo(void)
         }
     }
 
-    return std::make_tuple(accessControlFile, acfInstalled(), sDate);
+    cacheInfo(std::make_tuple(accessControlFile, acfInstalled(), sDate));
+    return *cachedInfo;
 }
 
 } // namespace cert
@@ -1,8 +1,16 @@
 #pragma once
 
+#include "watch.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
 #include <sdeventplus/source/event.hpp>
+#include <string>
+#include <vector>
 #include <xyz/openbmc_project/Certs/ACF/server.hpp>
 typedef std::tuple<std::vector<uint8_t>, bool, std::string> acf_info;
 
@@ -13,6 +21,8 @@ namespace cert
 
 class ACFCertMgr;
 
+constexpr auto ACF_FILE_PATH = "/etc/acf/service.acf";
+
 using CreateIface = sdbusplus::server::object::object<
     sdbusplus::xyz::openbmc_project::Certs::server::ACF>;
 using Mgr = acf::cert::ACFCertMgr;
@@ -35,11 +45,10 @@ class ACFCertMgr : public CreateIface
      *  @param[in] bus - Bus to attach to.
      *  @param[in] path - Path to attach at.
      *  @param[in] event - sd event handler.
+     *  @param[in] acfFilePath - Path of the installed ACF.
      */
     ACFCertMgr(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
-               const char* path) :
-        CreateIface(bus, path),
-        bus(bus), event(event), objectPath(path), lastEntryId(0){};
+               const char* path, std::string acfFilePath = ACF_FILE_PATH);
 
     /** @brief Implementation for InstallACF
      *  Replace the existing ACF with another ACF
@@ -52,11 +61,33 @@ class ACFCertMgr : public CreateIface
 
     /** @brief Implementation for GetACFInfo
      *  Returns contents of installed ACF
+     *  The ACF is verified once and the result kept until the file changes
+     *  or the next day starts, on which the ACF may have expired.
      *
      *  @return ACF related information.
      */
     acf_info getACFInfo(void) override;
 
+  protected:
+    /** @brief Verify the ACF with the tacf library
+     *  @param[in] accessControlFile - ACF contents.
+     *  @param[out] date - Expiration date of the ACF.
+     *  @return 0 if the ACF is valid, the tacf error code otherwise.
+     */
+    virtual int verifyACF(std::vector<uint8_t>& accessControlFile,
+                          std::string& date);
+
+    /** @brief Verify and install the ACF with the tacf library
+     *  @param[in] accessControlFile - ACF contents.
+     *  @param[out] date - Expiration date of the ACF.
+     *  @return 0 if the ACF got installed, the tacf error code otherwise.
+     */
+    virtual int writeACF(std::vector<uint8_t>& accessControlFile,
+                         std::string& date);
+
+    /** @brief Current time, which the cached result expires by */
+    virtual std::chrono::system_clock::time_point now() const;
+
   private:
     /** @brief sdbusplus DBus bus connection. */
     sdbusplus::bus::bus& bus;
@@ -64,8 +95,24 @@ class ACFCertMgr : public CreateIface
     sdeventplus::Event& event;
     /** @brief object path */
     std::string objectPath;
+    /** @brief Path of the installed ACF */
+    std::string acfFilePath;
     /** @brief Id of the last certificate entry */
     uint32_t lastEntryId;
+    /** @brief Result of the last ACF verification, if still valid */
+    std::optional<acf_info> cachedInfo;
+    /** @brief Time the cached result must be verified again */
+    std::chrono::system_clock::time_point cacheExpiry;
+    /** @brief Watch dropping the cached result when the ACF changes */
+    std::unique_ptr<phosphor::certs::Watch> acfWatch = nullptr;
+
+    /** @brief Keep the verification result until the next day starts
+     *  @param[in] info - ACF related information.
+     */
+    void cacheInfo(const acf_info& info);
+
+    /** @brief Whether the ACF file exists */
+    bool acfInstalled() const;
 };
 
 } // namespace cert
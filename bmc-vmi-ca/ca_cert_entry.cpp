@@ -1,15 +1,30 @@
-#include "config.h"
-
-#include "ca_cert_entry.hpp"
-
-#include "ca_certs_manager.hpp"
-
-namespace ca::cert
-{
-
-void Entry::delete_()
-{
-    // Remove entry D-bus object
-    manager.erase(id);
-}
-} // namespace ca::cert
+#include "config.h"
+
+#include "ca_cert_entry.hpp"
+
+#include "ca_certs_manager.hpp"
+
+#include <string>
+#include <utility>
+
+namespace ca::cert
+{
+
+void Entry::delete_()
+{
+    // Remove entry D-bus object
+    manager.erase(id);
+}
+
+std::string Entry::clientCertificate(std::string value, bool skipSignal)
+{
+    bool wasPending = clientCertificate().empty();
+    auto cert = sdbusplus::xyz::openbmc_project::Certs::server::Entry::
+        clientCertificate(std::move(value), skipSignal);
+    if (wasPending != cert.empty())
+    {
+        manager.pendingEntryChanged(cert.empty());
+    }
+    return cert;
+}
+} // namespace ca::cert
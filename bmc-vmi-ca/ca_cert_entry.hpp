@@ -55,12 +55,23 @@ class Entry : public internal::EntryInterface
         this->csr(csr);
         clientCertificate(cert);
 
-        // Emit deferred signal.
-        this->emit_object_added();
+        // The manager emits the deferred signal together with the ones of
+        // the other new entries
     };
 
     void delete_() override;
 
+    using sdbusplus::xyz::openbmc_project::Certs::server::Entry::
+        clientCertificate;
+
+    /** @brief Set the client certificate and tell the manager when the
+     *  entry stops or starts waiting for the hypervisor
+     *  @param[in] value - client certificate
+     *  @param[in] skipSignal - whether to skip the PropertiesChanged signal
+     *  @return the client certificate
+     */
+    std::string clientCertificate(std::string value, bool skipSignal) override;
+
   protected:
     /** @brief sdbusplus handler */
     sdbusplus::bus_t& bus;
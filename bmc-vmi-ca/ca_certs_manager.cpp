@@ -2,11 +2,17 @@
 
 #include "ca_certs_manager.hpp"
 
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+#include <set>
+#include <stdexcept>
+#include <utility>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 namespace ca::cert
@@ -17,12 +23,31 @@ using ::phosphor::logging::entry;
 using ::phosphor::logging::level;
 using ::phosphor::logging::log;
 
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 using ::sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
 using Argument =
     ::phosphor::logging::xyz::openbmc_project::Common::InvalidArgument;
+using NotAllowedReason =
+    ::phosphor::logging::xyz::openbmc_project::Common::NotAllowed::REASON;
 
 static constexpr size_t maxCertSize = 4096;
 
+const sdbusplus::vtable_t CACertMgr::queueVtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method("GetPendingCSRs", "u", "a(os)",
+                              CACertMgr::callGetPendingCSRs),
+    sdbusplus::vtable::method("CompleteCSRs", "a(os)", "",
+                              CACertMgr::callCompleteCSRs),
+    sdbusplus::vtable::end()};
+
+CACertMgr::CACertMgr(sdbusplus::bus_t& bus, sdeventplus::Event& event,
+                     const char* path) :
+    internal::ManagerInterface(bus, path),
+    bus(bus), event(event), objectPath(path),
+    queueInterface(bus, path, internal::queueInterfaceName, queueVtable, this)
+{}
+
 sdbusplus::message::object_path CACertMgr::signCSR(std::string csr)
 {
     std::string objPath;
@@ -34,9 +59,14 @@ sdbusplus::message::object_path CACertMgr::signCSR(std::string csr)
             elog<InvalidArgument>(Argument::ARGUMENT_NAME("CSR"),
                                   Argument::ARGUMENT_VALUE(csr.c_str()));
         }
+        if (numPendingEntries >= maxNumPendingVMICSRs)
+        {
+            log<level::ERR>("Too many CSRs wait for signing",
+                            entry("PENDING=%zu", numPendingEntries));
+            elog<NotAllowed>(NotAllowedReason("Too many pending CSRs"));
+        }
         auto id = lastEntryId + 1;
-        objPath =
-            fs::path(objectNamePrefix) / "ca" / "entry" / std::to_string(id);
+        objPath = getEntryPath(id);
         std::string cert;
         // Creating the dbus object here with the empty certificate string
         // actual signing is being done by the hypervisor, once it signs then
@@ -44,6 +74,8 @@ sdbusplus::message::object_path CACertMgr::signCSR(std::string csr)
         entries.insert(std::make_pair(
             id, std::make_unique<Entry>(bus, objPath, id, csr, cert, *this)));
         lastEntryId++;
+        numPendingEntries++;
+        unannouncedEntries.push_back(id);
     }
     catch (const std::invalid_argument& e)
     {
@@ -51,23 +83,184 @@ sdbusplus::message::object_path CACertMgr::signCSR(std::string csr)
         elog<InvalidArgument>(Argument::ARGUMENT_NAME("csr"),
                               Argument::ARGUMENT_VALUE(csr.c_str()));
     }
+
+    // A burst of requests gets announced at once after the last one
+    if (!announceSource)
+    {
+        announceSource = std::make_unique<sdeventplus::source::Defer>(
+            event,
+            [this](sdeventplus::source::EventBase&) { announceEntries(); });
+        announceSource->set_priority(SD_EVENT_PRIORITY_IDLE);
+    }
+    announceSource->set_enabled(sdeventplus::source::Enabled::OneShot);
     return objPath;
 }
 
+void CACertMgr::announceEntries()
+{
+    for (uint32_t id : unannouncedEntries)
+    {
+        // Entries deleted in the meantime never show up at all
+        if (auto found = entries.find(id); found != entries.end())
+        {
+            found->second->emit_object_added();
+        }
+    }
+    unannouncedEntries.clear();
+}
+
+std::vector<CACertMgr::PendingCSR> CACertMgr::getPendingCSRs(uint32_t maxCount)
+{
+    std::vector<PendingCSR> pending;
+    for (const auto& [id, csrEntry] : entries)
+    {
+        if (maxCount != 0 && pending.size() == maxCount)
+        {
+            break;
+        }
+        if (csrEntry->clientCertificate().empty())
+        {
+            pending.emplace_back(getEntryPath(id), csrEntry->csr());
+        }
+    }
+    return pending;
+}
+
+void CACertMgr::completeCSRs(const std::vector<SignedCSR>& certificates)
+{
+    std::vector<std::pair<Entry*, const std::string*>> completions;
+    completions.reserve(certificates.size());
+    std::set<uint32_t> completedIds;
+    for (const auto& [path, cert] : certificates)
+    {
+        const std::string& entryPath = path.str;
+        auto found = entries.end();
+        size_t pos = entryPath.rfind('/');
+        if (pos != std::string::npos)
+        {
+            try
+            {
+                auto id = static_cast<uint32_t>(
+                    std::stoul(entryPath.substr(pos + 1)));
+                if (getEntryPath(id) == entryPath)
+                {
+                    found = entries.find(id);
+                }
+            }
+            catch (const std::logic_error&)
+            {}
+        }
+        // Entries are signed once, also within a batch
+        if (found == entries.end() ||
+            !found->second->clientCertificate().empty() || cert.empty() ||
+            cert.size() > maxCertSize ||
+            !completedIds.insert(found->first).second)
+        {
+            log<level::ERR>("Invalid signed CSR",
+                            entry("ENTRY=%s", entryPath.c_str()));
+            elog<InvalidArgument>(Argument::ARGUMENT_NAME("ENTRY"),
+                                  Argument::ARGUMENT_VALUE(entryPath.c_str()));
+        }
+        completions.emplace_back(found->second.get(), &cert);
+    }
+    for (auto& [csrEntry, cert] : completions)
+    {
+        csrEntry->clientCertificate(*cert);
+    }
+}
+
+int CACertMgr::callGetPendingCSRs(sd_bus_message* msg, void* context,
+                                  sd_bus_error* error)
+{
+    auto manager = static_cast<CACertMgr*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        uint32_t maxCount = 0;
+        call.read(maxCount);
+        auto reply = call.new_method_return();
+        reply.append(manager->getPendingCSRs(maxCount));
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        // Unwinding through the sd-bus callback would abort the daemon
+        log<level::ERR>("Failed to handle the CSR batch call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+int CACertMgr::callCompleteCSRs(sd_bus_message* msg, void* context,
+                                sd_bus_error* error)
+{
+    auto manager = static_cast<CACertMgr*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        std::vector<SignedCSR> certificates;
+        call.read(certificates);
+        manager->completeCSRs(certificates);
+        auto reply = call.new_method_return();
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to handle the CSR batch call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+std::string CACertMgr::getEntryPath(uint32_t entryId)
+{
+    return fs::path(objectNamePrefix) / "ca" / "entry" /
+           std::to_string(entryId);
+}
+
 void CACertMgr::erase(uint32_t entryId)
 {
-    entries.erase(entryId);
+    auto found = entries.find(entryId);
+    if (found == entries.end())
+    {
+        return;
+    }
+    if (found->second->clientCertificate().empty())
+    {
+        numPendingEntries--;
+    }
+    entries.erase(found);
 }
 
-void CACertMgr::deleteAll()
+void CACertMgr::pendingEntryChanged(bool pending)
 {
-    auto iter = entries.begin();
-    while (iter != entries.end())
+    if (pending)
+    {
+        numPendingEntries++;
+    }
+    else
     {
-        auto& entry = iter->second;
-        ++iter;
-        entry->delete_();
+        numPendingEntries--;
     }
 }
 
+void CACertMgr::deleteAll()
+{
+    // Entries not announced yet go away without a signal; each announced one
+    // still emits its own InterfacesRemoved, which holds a single path
+    unannouncedEntries.clear();
+    entries.clear();
+    numPendingEntries = 0;
+}
+
 } // namespace ca::cert
@@ -4,8 +4,22 @@
 #include "xyz/openbmc_project/Certs/Authority/server.hpp"
 #include "xyz/openbmc_project/Collection/DeleteAll/server.hpp"
 
+#include <systemd/sd-bus.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <sdbusplus/bus.hpp>
+#include <sdbusplus/message/native_types.hpp>
+#include <sdbusplus/server/interface.hpp>
 #include <sdbusplus/server/object.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/event.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
 
 namespace ca::cert
 {
@@ -15,7 +29,11 @@ namespace internal
 using ManagerInterface = sdbusplus::server::object_t<
     sdbusplus::xyz::openbmc_project::Certs::server::Authority,
     sdbusplus::xyz::openbmc_project::Collection::server::DeleteAll>;
-}
+
+/** @brief Interface handing the pending CSRs to the hypervisor in batches */
+inline constexpr char queueInterfaceName[] =
+    "xyz.openbmc_project.Certs.ca.authority.Queue";
+} // namespace internal
 
 class CACertMgr;
 
@@ -33,28 +51,64 @@ class CACertMgr : public internal::ManagerInterface
     CACertMgr& operator=(CACertMgr&&) = delete;
     virtual ~CACertMgr() = default;
 
+    /** @brief A CSR waiting for the hypervisor: its entry path and the CSR
+     */
+    using PendingCSR = std::tuple<sdbusplus::message::object_path, std::string>;
+
+    /** @brief A CSR the hypervisor signed: its entry path and the client
+     *  certificate
+     */
+    using SignedCSR = std::tuple<sdbusplus::message::object_path, std::string>;
+
     /** @brief Constructor to put object onto bus at a dbus path.
      *  @param[in] bus - Bus to attach to.
+     *  @param[in] event - sd-event the new entries get announced from.
      *  @param[in] path - Path to attach at.
      */
-    CACertMgr(sdbusplus::bus_t& bus, const char* path) :
-        internal::ManagerInterface(bus, path), bus(bus), objectPath(path),
-        lastEntryId(0){};
+    CACertMgr(sdbusplus::bus_t& bus, sdeventplus::Event& event,
+              const char* path);
 
     /** @brief This method provides signing authority functionality.
                It signs the certificate and creates the CSR request entry Dbus
      Object.
+     *  The entries created while the event loop is busy are announced
+     *  once it is idle, their InterfacesAdded signals back to back. The
+     *  signal carries a single object path, so they can't be merged into
+     *  one. Requests are refused with NotAllowed while
+     *  maxNumPendingVMICSRs of them wait for the hypervisor.
      *  @param[in] csr - csr string
      *  @return Object path
      */
     sdbusplus::message::object_path signCSR(std::string csr) override;
 
+    /** @brief Get the CSRs waiting for the hypervisor, oldest first
+     *  @param[in] maxCount - Maximum number of CSRs to return; 0 returns all.
+     *  @return the pending CSRs
+     */
+    std::vector<PendingCSR> getPendingCSRs(uint32_t maxCount);
+
+    /** @brief Set the client certificates of several pending entries at
+     *  once; either all of them are set or, if any is invalid or listed
+     *  twice, none
+     *  @param[in] certificates - The signed CSRs.
+     */
+    void completeCSRs(const std::vector<SignedCSR>& certificates);
+
     /** @brief Erase specified entry d-bus object
      *  @param[in] entryId - unique identifier of the entry
      */
     void erase(uint32_t entryId);
 
+    /** @brief Count an entry that started or stopped waiting for the
+     *  hypervisor
+     *  @param[in] pending - whether the entry waits now
+     */
+    void pendingEntryChanged(bool pending);
+
     /** @brief  Erase all entries
+     *  The entries not announced yet go away without any signal; the
+     *  announced ones still emit an InterfacesRemoved signal each, as the
+     *  signal carries a single object path and can't be merged.
      */
     void deleteAll() override;
 
@@ -62,12 +116,41 @@ class CACertMgr : public internal::ManagerInterface
     std::map<uint32_t, std::unique_ptr<Entry>> entries;
 
   private:
+    /** @brief Object path of the entry
+     *  @param[in] entryId - unique identifier of the entry
+     */
+    static std::string getEntryPath(uint32_t entryId);
+
+    /** @brief Emit the InterfacesAdded signals of the new entries, one per
+     *  entry
+     */
+    void announceEntries();
+
+    /** @brief D-Bus handlers of the queue interface */
+    static int callGetPendingCSRs(sd_bus_message* msg, void* context,
+                                  sd_bus_error* error);
+    static int callCompleteCSRs(sd_bus_message* msg, void* context,
+                                sd_bus_error* error);
+
+    /** @brief Methods of the queue interface */
+    static const sdbusplus::vtable_t queueVtable[];
+
     /** @brief sdbusplus DBus bus connection. */
     sdbusplus::bus_t& bus;
+    /** @brief sd-event object */
+    sdeventplus::Event& event;
     /** @brief object path */
     std::string objectPath;
     /** @brief Id of the last certificate entry */
-    uint32_t lastEntryId;
+    uint32_t lastEntryId = 0;
+    /** @brief Number of entries waiting for the hypervisor */
+    size_t numPendingEntries = 0;
+    /** @brief Ids of the entries created since the last announcement */
+    std::vector<uint32_t> unannouncedEntries;
+    /** @brief Idle priority source announcing the new entries */
+    std::unique_ptr<sdeventplus::source::Defer> announceSource = nullptr;
+    /** @brief The queue interface */
+    sdbusplus::server::interface_t queueInterface;
 };
 
 } // namespace ca::cert
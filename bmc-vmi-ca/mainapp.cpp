@@ -3,20 +3,23 @@
 #include "ca_certs_manager.hpp"
 
 #include <sdbusplus/server/manager.hpp>
+#include <sdeventplus/event.hpp>
 #include <string>
 
 int main()
 {
     auto bus = sdbusplus::bus::new_default();
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
     static constexpr auto objPath = "/xyz/openbmc_project/certs/ca";
 
     // Add sdbusplus ObjectManager
     sdbusplus::server::manager_t objManager(bus, objPath);
 
-    ca::cert::CACertMgr manager(bus, objPath);
+    ca::cert::CACertMgr manager(bus, event, objPath);
 
     std::string busName = "xyz.openbmc_project.Certs.ca.authority.Manager";
     bus.request_name(busName.c_str());
-    bus.process_loop();
-    return 0;
+    return event.loop();
 }
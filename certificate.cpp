@@ -2,7 +2,9 @@
 
 #include "certificate.hpp"
 
+#include "authority_store.hpp"
 #include "certs_manager.hpp"
+#include "file_utils.hpp"
 #include "x509_utils.hpp"
 
 #include <openssl/asn1.h>
@@ -18,10 +20,8 @@
 
 #include <cstdint>
 #include <cstdio>
-#include <cstdlib>
 #include <exception>
 #include <filesystem>
-#include <fstream>
 #include <map>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
@@ -92,104 +92,83 @@ std::map<uint8_t, std::string> extendedKeyUsageToRfStr = {
  * @return void
  */
 
-void dumpCertificate(const std::string& pem, const std::string& certFilePath)
+void dumpCertificate(std::string_view pem, const std::string& certFilePath)
 {
-    std::ofstream outputCertFileStream;
-
-    outputCertFileStream.exceptions(
-        std::ofstream::failbit | std::ofstream::badbit | std::ofstream::eofbit);
+    std::string content(pem);
+    content += '\n';
+    writeFileAtomically(certFilePath, content);
+}
 
-    try
+/**
+ * @brief Find the private key file to append to a certificate uploaded
+ * without its key: the key of the CSR the certificate was signed for, else the
+ * default private key file.
+ *
+ * @param[in] certDir - Directory of the installed certificate.
+ * @param[in] cert - The uploaded certificate.
+ * @param[out] key - The private key of the file, if it could be decoded.
+ *
+ * @return the private key file path
+ */
+fs::path findPrivateKeyFile(const fs::path& certDir, X509& cert,
+                            EVPPkeyPtr& key)
+{
+    fs::path defaultKeyFile = certDir / defaultPrivateKeyFileName;
+    std::vector<fs::path> keyFiles{defaultKeyFile};
+    std::error_code ec;
+    for (const auto& csrDir :
+         fs::directory_iterator(certDir / defaultCSRDirName, ec))
     {
-        outputCertFileStream.open(certFilePath, std::ios::out);
-        outputCertFileStream << pem << "\n" << std::flush;
-        outputCertFileStream.close();
+        keyFiles.emplace_back(csrDir.path() / defaultPrivateKeyFileName);
     }
-    catch (const std::exception& e)
+    EVPPkeyPtr defaultKey(nullptr, ::EVP_PKEY_free);
+    for (const auto& keyFile : keyFiles)
     {
-        log<level::ERR>("Failed to dump certificate", entry("ERR=%s", e.what()),
-                        entry("SRC_PEM=%s", pem.c_str()),
-                        entry("DST=%s", certFilePath.c_str()));
-        elog<InternalFailure>();
-    }
-}
-} // namespace
-
-void Certificate::copyCertificate(const std::string& certSrcFilePath,
-                                  const std::string& certFilePath)
-{
-    // Copy the certificate to the installation path
-    // During bootup will be parsing existing file so no need to
-    // copy it.
-    if (certSrcFilePath != certFilePath)
-    {
-        std::ifstream inputCertFileStream;
-        std::ofstream outputCertFileStream;
-        inputCertFileStream.exceptions(std::ifstream::failbit |
-                                       std::ifstream::badbit |
-                                       std::ifstream::eofbit);
-        outputCertFileStream.exceptions(std::ofstream::failbit |
-                                        std::ofstream::badbit |
-                                        std::ofstream::eofbit);
-        try
+        BIOMemPtr keyBio(BIO_new_file(keyFile.c_str(), "rb"), ::BIO_free);
+        if (!keyBio)
         {
-            inputCertFileStream.open(certSrcFilePath);
-            outputCertFileStream.open(certFilePath, std::ios::out);
-            outputCertFileStream << inputCertFileStream.rdbuf() << std::flush;
-            inputCertFileStream.close();
-            outputCertFileStream.close();
+            continue;
         }
-        catch (const std::exception& e)
+        EVPPkeyPtr fileKey(
+            PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr),
+            ::EVP_PKEY_free);
+        if (fileKey && X509_check_private_key(&cert, fileKey.get()) == 1)
         {
-            log<level::ERR>("Failed to copy certificate",
-                            entry("ERR=%s", e.what()),
-                            entry("SRC=%s", certSrcFilePath.c_str()),
-                            entry("DST=%s", certFilePath.c_str()));
-            elog<InternalFailure>();
+            key = std::move(fileKey);
+            return keyFile;
+        }
+        if (keyFile == defaultKeyFile)
+        {
+            defaultKey = std::move(fileKey);
         }
     }
+    // Mismatching keys leave errors behind in the queue
+    ERR_clear_error();
+    // The key comparison reports the mismatch
+    key = std::move(defaultKey);
+    return defaultKeyFile;
 }
 
-std::string
-    Certificate::generateUniqueFilePath(const std::string& directoryPath)
-{
-    char* filePath = tempnam(directoryPath.c_str(), nullptr);
-    if (filePath == nullptr)
-    {
-        log<level::ERR>(
-            "Error occurred while creating random certificate file path",
-            entry("DIR=%s", directoryPath.c_str()));
-        elog<InternalFailure>();
-    }
-    std::string filePathStr(filePath);
-    free(filePath);
-    return filePathStr;
-}
-
-std::string Certificate::generateAuthCertFileX509Path(
-    const std::string& certSrcFilePath, const std::string& certDstDirPath)
+// Convert an ASN1 time to seconds since epoch
+uint64_t secondsSinceEpoch(const ASN1_TIME* time)
 {
-    const internal::X509Ptr cert = loadCert(certSrcFilePath);
-    unsigned long hash = X509_subject_name_hash(cert.get());
-    static constexpr auto certHashLength = 9;
-    char hashBuf[certHashLength];
+    int days = 0;
+    int secs = 0;
 
-    snprintf(hashBuf, certHashLength, "%08lx", hash);
+    ASN1TimePtr epoch(ASN1_TIME_new(), ASN1_STRING_free);
+    // Set time to 00:00am GMT, Jan 1 1970; format: YYYYMMDDHHMMSSZ
+    ASN1_TIME_set_string(epoch.get(), "19700101000000Z");
 
-    const std::string certHash(hashBuf);
-    for (size_t i = 0; i < maxNumAuthorityCertificates; ++i)
-    {
-        const std::string certDstFileX509Path =
-            certDstDirPath + "/" + certHash + "." + std::to_string(i);
-        if (!fs::exists(certDstFileX509Path))
-        {
-            return certDstFileX509Path;
-        }
-    }
+    static const uint64_t dayToSeconds = 24 * 60 * 60;
+    ASN1_TIME_diff(&days, &secs, epoch.get(), time);
+    return (days * dayToSeconds) + secs;
+}
+} // namespace
 
-    log<level::ERR>("Authority certificate x509 file path already used",
-                    entry("DIR=%s", certDstDirPath.c_str()));
-    elog<InternalFailure>();
+std::string
+    Certificate::generateUniqueFilePath(const std::string& directoryPath)
+{
+    return createUniqueFile(directoryPath);
 }
 
 std::string
@@ -208,10 +187,11 @@ std::string
     {
         return certSrcFilePath;
     }
-    // Otherwise generate new file name/path
+    // Otherwise the certificate gets a new file once it is valid, see
+    // commit()
     else
     {
-        return generateUniqueFilePath(certInstallPath);
+        return std::string();
     }
 }
 
@@ -238,39 +218,39 @@ Certificate::Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
     objectPath(objPath), certType(type), certInstallPath(installPath),
     certWatch(watch), manager(parent)
 {
-    auto installHelper = [this](const auto& filePath) {
-        if (!compareKeys(filePath))
-        {
-            elog<InvalidCertificateError>(InvalidCertificate::REASON(
-                "Private key does not match the Certificate"));
-        };
-    };
-    typeFuncMap[CertificateType::server] = installHelper;
-    typeFuncMap[CertificateType::client] = installHelper;
-    typeFuncMap[CertificateType::authority] = [](const std::string&) {};
-
-    auto appendPrivateKey = [this](const std::string& filePath) {
-        checkAndAppendPrivateKey(filePath);
-    };
-
-    appendKeyMap[CertificateType::server] = appendPrivateKey;
-    appendKeyMap[CertificateType::client] = appendPrivateKey;
-    appendKeyMap[CertificateType::authority] = [](const std::string&) {};
-
     // Generate certificate file path
     certFilePath = generateCertFilePath(uploadPath);
 
     // install the certificate
     install(uploadPath, restore);
 
-    this->emit_object_added();
+    publish();
+}
+
+Certificate::Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
+                         CertificateType type, const std::string& installPath,
+                         const std::string& uploadPath, X509& cert,
+                         std::string_view pem, Watch* watch, Manager& parent) :
+    internal::CertificateInterface(
+        bus, objPath.c_str(),
+        internal::CertificateInterface::action::defer_emit),
+    objectPath(objPath), certType(type), certInstallPath(installPath),
+    certWatch(watch), manager(parent)
+{
+    // Generate certificate file path
+    certFilePath = generateCertFilePath(uploadPath);
+
+    // the certificate is already validated; only install it
+    commit(uploadPath, cert, pem);
+
+    publish();
 }
 
 Certificate::Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
                          const CertificateType& type,
-                         const std::string& installPath, X509_STORE& x509Store,
-                         const std::string& pem, Watch* watchPtr,
-                         Manager& parent, bool restore) :
+                         const std::string& installPath, X509& cert,
+                         std::string_view pem, Watch* watchPtr, Manager& parent,
+                         bool restore) :
     internal::CertificateInterface(
         bus, objPath.c_str(),
         internal::CertificateInterface::action::defer_emit),
@@ -280,10 +260,40 @@ Certificate::Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
     // Generate certificate file path
     certFilePath = generateUniqueFilePath(installPath);
 
-    // install the certificate
-    install(x509Store, pem, restore);
+    // install the certificate; the manager publishes the whole list once it
+    // is committed
+    install(cert, pem, restore);
+}
 
-    this->emit_object_added();
+Certificate::Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
+                         CertificateType type, const std::string& installPath,
+                         const StoreIndexEntry& indexEntry, Watch* watch,
+                         Manager& parent) :
+    internal::CertificateInterface(
+        bus, objPath.c_str(),
+        internal::CertificateInterface::action::defer_emit),
+    objectPath(objPath), certType(type), certId(indexEntry.certId),
+    subjectNameHash(indexEntry.subjectNameHash),
+    fingerprint(indexEntry.fingerprint),
+    certFilePath(fs::path(installPath) / indexEntry.fileName),
+    certInstallPath(installPath), certWatch(watch), manager(parent)
+{
+    log<level::DEBUG>("Certificate restore from index",
+                      entry("FILEPATH=%s", certFilePath.c_str()));
+
+    // The file isn't parsed; isSame() falls back to the cached ID
+    certificateString(indexEntry.certificateString);
+    if (certType == CertificateType::authority)
+    {
+        installedPem = indexEntry.certificateString;
+    }
+    subject(indexEntry.subject);
+    issuer(indexEntry.issuer);
+    keyUsage(indexEntry.keyUsage);
+    validNotBefore(indexEntry.validNotBefore);
+    validNotAfter(indexEntry.validNotAfter);
+
+    publish();
 }
 
 Certificate::~Certificate()
@@ -313,12 +323,35 @@ void Certificate::install(const std::string& certSrcFilePath, bool restore)
                          entry("FILEPATH=%s", certSrcFilePath.c_str()));
     }
 
-    // stop watch for user initiated certificate install
-    if (certWatch != nullptr)
-    {
-        certWatch->stopWatch();
-    }
+    // ignore the changes of user initiated certificate install
+    Watch::Suppression suppression = suppressWatch();
+
+    std::string pem;
+    internal::X509Ptr cert =
+        validate(certType, certInstallPath, certSrcFilePath, pem, restore);
+    commit(certSrcFilePath, *cert, pem);
+}
+
+void Certificate::installContent(std::string pem)
+{
+    log<level::INFO>("Certificate install from content",
+                     entry("OBJPATH=%s", objectPath.c_str()));
+
+    // ignore the changes of user initiated certificate install
+    Watch::Suppression suppression = suppressWatch();
+
+    internal::X509Ptr cert = validateContent(certType, certInstallPath,
+                                             "<content>", pem,
+                                             /*restore=*/false);
+    // No source file; the content is always written
+    commit(std::string(), *cert, pem);
+}
 
+internal::X509Ptr Certificate::validate(CertificateType type,
+                                        const std::string& installPath,
+                                        const std::string& certSrcFilePath,
+                                        std::string& pem, bool restore)
+{
     // Verify the certificate file
     fs::path file(certSrcFilePath);
     if (!fs::exists(file))
@@ -346,68 +379,129 @@ void Certificate::install(const std::string& certSrcFilePath, bool restore)
         elog<InternalFailure>();
     }
 
-    X509StorePtr x509Store = getX509Store(certSrcFilePath);
+    // Read and decode the file once
+    pem = readFile(certSrcFilePath);
+    return validateContent(type, installPath, certSrcFilePath, pem, restore);
+}
 
-    // Load Certificate file into the X509 structure.
-    internal::X509Ptr cert = loadCert(certSrcFilePath);
+internal::X509Ptr Certificate::validateContent(CertificateType type,
+                                               const std::string& installPath,
+                                               const std::string& source,
+                                               std::string& pem, bool restore)
+{
+    // The first certificate is validated
+    std::vector<internal::X509Ptr> certs = parseCerts(pem);
 
-    // Perform validation
-    validateCertificateAgainstStore(*x509Store, *cert);
-    validateCertificateStartDate(*cert);
-    validateCertificateInSSLContext(*cert);
+    // Installed certificates are restored even if the authorities changed
+    std::shared_ptr<X509_STORE> authorities;
+    AuthorityStore& authorityStore = AuthorityStore::getInstance();
+    if (authorityStore.isEnabled() && type != CertificateType::authority &&
+        !restore)
+    {
+        authorities = authorityStore.get();
+    }
 
-    // Invoke type specific append private key function.
-    if (auto it = appendKeyMap.find(certType); it == appendKeyMap.end())
+    // Perform validation
+    internal::X509Ptr cert(nullptr, ::X509_free);
+    if (authorities)
     {
-        log<level::ERR>("Unsupported Type",
-                        entry("TYPE=%s", certificateTypeToString(certType)));
-        elog<InternalFailure>();
+        // The other certificates of the file may complete the chain
+        cert = std::move(certs.front());
+        validateCertificateChain(*authorities, *cert, certs);
     }
     else
     {
-        it->second(certSrcFilePath);
+        // The store gets every certificate of the file, e.g. its chain
+        X509StorePtr x509Store = getX509Store(certs);
+        cert = std::move(certs.front());
+        validateCertificateAgainstStore(*x509Store, *cert);
     }
+    validateCertificateStartDate(*cert);
+    validateCertificateInSSLContext(*cert);
 
-    // Invoke type specific compare keys function.
-    if (auto it = typeFuncMap.find(certType); it == typeFuncMap.end())
+    // Type specific private key handling
+    switch (type)
     {
-        log<level::ERR>("Unsupported Type",
-                        entry("TYPE=%s", certificateTypeToString(certType)));
-        elog<InternalFailure>();
+        case CertificateType::server:
+        case CertificateType::client:
+            // Append the existing private key if the file lacks one, then
+            // make sure the key matches the certificate
+            if (internal::EVPPkeyPtr priKey = checkAndAppendPrivateKey(
+                    installPath, source, pem, *cert);
+                !compareKeys(source, *cert, *priKey))
+            {
+                elog<InvalidCertificateError>(InvalidCertificate::REASON(
+                    "Private key does not match the Certificate"));
+            }
+            break;
+        case CertificateType::authority:
+            break;
+        default:
+            log<level::ERR>("Unsupported Type",
+                            entry("TYPE=%s", certificateTypeToString(type)));
+            elog<InternalFailure>();
     }
-    else
+    return cert;
+}
+
+void Certificate::commit(const std::string& certSrcFilePath, X509& cert,
+                         std::string_view pem)
+{
+    // ignore the changes while the installed file gets replaced
+    Watch::Suppression suppression = suppressWatch();
+
+    if (certFilePath.empty())
     {
-        it->second(certSrcFilePath);
+        // Reserve a new file name; a failed copy must not leave it behind
+        certFilePath = generateUniqueFilePath(certInstallPath);
+        try
+        {
+            writeFileAtomically(certFilePath, pem);
+        }
+        catch (...)
+        {
+            std::error_code ec;
+            fs::remove(certFilePath, ec);
+            certFilePath.clear();
+            throw;
+        }
+    }
+    // During bootup the existing file is installed as is, unless the
+    // private key was appended to its content
+    else if (std::error_code ec;
+             certSrcFilePath != certFilePath ||
+             fs::file_size(certSrcFilePath, ec) != pem.size())
+    {
+        writeFileAtomically(certFilePath, pem);
     }
 
-    copyCertificate(certSrcFilePath, certFilePath);
-    storageUpdate();
-
-    // Keep certificate ID
-    certId = generateCertId(*cert);
+    // Keep certificate ID, subject name hash and the certificate itself
+    cacheCertificate(cert);
+    if (certType == CertificateType::authority)
+    {
+        // As the store index keeps it, so a restart bundles the same PEM
+        installedPem = encodeCert(cert);
+    }
 
     // Parse the certificate file and populate properties
-    populateProperties(*cert);
+    populateProperties(cert);
+}
 
-    // restart watch
-    if (certWatch != nullptr)
-    {
-        certWatch->startWatch();
-    }
+void Certificate::validate(X509_STORE& x509Store, X509& cert)
+{
+    // No type specific compare keys function for authorities
+    validateCertificateAgainstStore(x509Store, cert);
+    validateCertificateStartDate(cert);
+    validateCertificateInSSLContext(cert);
 }
 
-void Certificate::install(X509_STORE& x509Store, const std::string& pem,
-                          bool restore)
+void Certificate::install(X509& cert, std::string_view pem, bool restore)
 {
-    if (restore)
+    if constexpr (logCertificatePem)
     {
         log<level::DEBUG>("Certificate install ",
-                          entry("PEM_STR=%s", pem.data()));
-    }
-    else
-    {
-        log<level::INFO>("Certificate install ",
-                         entry("PEM_STR=%s", pem.data()));
+                          entry("PEM_STR=%.*s", static_cast<int>(pem.size()),
+                                pem.data()));
     }
 
     if (certType != CertificateType::authority)
@@ -418,88 +512,177 @@ void Certificate::install(X509_STORE& x509Store, const std::string& pem,
         elog<InternalFailure>();
     }
 
-    // stop watch for user initiated certificate install
-    if (certWatch)
-    {
-        certWatch->stopWatch();
-    }
-
-    // Load Certificate file into the X509 structure.
-    internal::X509Ptr cert = parseCert(pem);
-    // Perform validation; no type specific compare keys function
-    validateCertificateAgainstStore(x509Store, *cert);
-    validateCertificateStartDate(*cert);
-    validateCertificateInSSLContext(*cert);
+    // ignore the changes of user initiated certificate install
+    Watch::Suppression suppression = suppressWatch();
 
     // Copy the PEM to the installation path
     dumpCertificate(pem, certFilePath);
-    storageUpdate();
-    // Keep certificate ID
-    certId = generateCertId(*cert);
-    // Parse the certificate file and populate properties
-    populateProperties(*cert);
-    // restart watch
-    if (certWatch)
-    {
-        certWatch->startWatch();
-    }
+    // Keep certificate ID, subject name hash and the certificate itself
+    cacheCertificate(cert);
+    installedPem = encodeCert(cert);
+    // The list install logs the summary; one record per entry is enough
+    // for debugging
+    log<level::DEBUG>("Certificate install ",
+                      entry("FINGERPRINT=%s", fingerprint.c_str()),
+                      entry("RESTORE=%d", restore));
+    // Populate properties from the already parsed certificate
+    populateProperties(cert);
+}
+
+Watch::Suppression Certificate::suppressWatch()
+{
+    return certWatch != nullptr ? certWatch->suppress() : Watch::Suppression();
 }
 
 void Certificate::populateProperties()
 {
     internal::X509Ptr cert = loadCert(certInstallPath);
+    cacheCertificate(*cert);
     populateProperties(*cert);
 }
 
+void Certificate::cacheCertificate(X509& cert)
+{
+    certId = generateCertId(cert);
+    subjectNameHash = generateSubjectNameHash(cert);
+    fingerprint = generateFingerprint(cert);
+    X509_up_ref(&cert);
+    x509.reset(&cert);
+}
+
 std::string Certificate::getCertId() const
 {
     return certId;
 }
 
-bool Certificate::isSame(const std::string& certPath)
+X509* Certificate::getX509() const
 {
-    internal::X509Ptr cert = loadCert(certPath);
-    return getCertId() == generateCertId(*cert);
+    return x509.get();
 }
 
-void Certificate::storageUpdate()
+const std::string& Certificate::getPem() const
 {
-    if (certType == CertificateType::authority)
+    return installedPem;
+}
+
+const std::string& Certificate::getSubjectNameHash() const
+{
+    return subjectNameHash;
+}
+
+uint64_t Certificate::getExpirationTime() const
+{
+    if (propertiesPending)
     {
-        // Create symbolic link in the certificate directory
-        std::string certFileX509Path;
-        try
-        {
-            if (!certFilePath.empty() &&
-                fs::is_regular_file(fs::path(certFilePath)))
-            {
-                certFileX509Path =
-                    generateAuthCertFileX509Path(certFilePath, certInstallPath);
-                fs::create_symlink(fs::path(certFilePath),
-                                   fs::path(certFileX509Path));
-            }
-        }
-        catch (const std::exception& e)
+        return secondsSinceEpoch(X509_get0_notAfter(x509.get()));
+    }
+    return internal::CertificateProperties::validNotAfter();
+}
+
+const std::string& Certificate::getFingerprint() const
+{
+    return fingerprint;
+}
+
+bool Certificate::isSame(X509& cert) const
+{
+    // X509_cmp() compares the digests OpenSSL cached while parsing; fall back
+    // to the certificate ID which tolerates re-encoded certificates
+    if (x509 && X509_cmp(x509.get(), &cert) == 0)
+    {
+        return true;
+    }
+    return getCertId() == generateCertId(cert);
+}
+
+bool Certificate::isAnnouncementPending() const
+{
+    return !announced;
+}
+
+void Certificate::announce()
+{
+    materializeProperties();
+    this->emit_object_added();
+    announced = true;
+}
+
+void Certificate::publish()
+{
+    if (propertiesPending)
+    {
+        manager.scheduleIdleWork();
+        return;
+    }
+    announce();
+}
+
+void Certificate::materializeProperties() const
+{
+    if (!propertiesPending)
+    {
+        return;
+    }
+    // Nobody saw the previous values, so there is nothing to signal
+    const_cast<Certificate*>(this)->setProperties(*x509, /*skipSignal=*/true);
+}
+
+std::string Certificate::certificateString() const
+{
+    materializeProperties();
+    return internal::CertificateProperties::certificateString();
+}
+
+std::string Certificate::issuer() const
+{
+    materializeProperties();
+    return internal::CertificateProperties::issuer();
+}
+
+std::vector<std::string> Certificate::keyUsage() const
+{
+    materializeProperties();
+    return internal::CertificateProperties::keyUsage();
+}
+
+std::string Certificate::subject() const
+{
+    materializeProperties();
+    return internal::CertificateProperties::subject();
+}
+
+uint64_t Certificate::validNotAfter() const
+{
+    materializeProperties();
+    return internal::CertificateProperties::validNotAfter();
+}
+
+uint64_t Certificate::validNotBefore() const
+{
+    materializeProperties();
+    return internal::CertificateProperties::validNotBefore();
+}
+
+void Certificate::populateProperties(X509& cert)
+{
+    if constexpr (lazyProperties)
+    {
+        // Until the object is announced, build the properties only when they
+        // are read or the event loop is idle; |x509| holds |cert| meanwhile
+        if (!announced)
         {
-            log<level::ERR>("Failed to create symlink for certificate",
-                            entry("ERR=%s", e.what()),
-                            entry("FILE=%s", certFilePath.c_str()),
-                            entry("SYMLINK=%s", certFileX509Path.c_str()));
-            elog<InternalFailure>();
+            propertiesPending = true;
+            return;
         }
     }
+    setProperties(cert, /*skipSignal=*/false);
 }
 
-void Certificate::populateProperties(X509& cert)
+void Certificate::setProperties(X509& cert, bool skipSignal)
 {
+    propertiesPending = false;
     // Update properties if no error thrown
-    BIOMemPtr certBio(BIO_new(BIO_s_mem()), BIO_free);
-    PEM_write_bio_X509(certBio.get(), &cert);
-    BufMemPtr certBuf(BUF_MEM_new(), BUF_MEM_free);
-    BUF_MEM* buf = certBuf.get();
-    BIO_get_mem_ptr(certBio.get(), &buf);
-    std::string certStr(buf->data, buf->length);
-    certificateString(certStr);
+    certificateString(encodeCert(cert), skipSignal);
 
     static const int maxKeySize = 4096;
     char subBuffer[maxKeySize] = {0};
@@ -508,7 +691,7 @@ void Certificate::populateProperties(X509& cert)
     X509_NAME* sub = X509_get_subject_name(&cert);
     X509_NAME_print_ex(subBio.get(), sub, 0, XN_FLAG_SEP_COMMA_PLUS);
     BIO_read(subBio.get(), subBuffer, maxKeySize);
-    subject(subBuffer);
+    subject(subBuffer, skipSignal);
 
     char issuerBuffer[maxKeySize] = {0};
     BIOMemPtr issuerBio(BIO_new(BIO_s_mem()), BIO_free);
@@ -516,7 +699,7 @@ void Certificate::populateProperties(X509& cert)
     X509_NAME* issuerName = X509_get_issuer_name(&cert);
     X509_NAME_print_ex(issuerBio.get(), issuerName, 0, XN_FLAG_SEP_COMMA_PLUS);
     BIO_read(issuerBio.get(), issuerBuffer, maxKeySize);
-    issuer(issuerBuffer);
+    issuer(issuerBuffer, skipSignal);
 
     std::vector<std::string> keyUsageList;
     ASN1_BIT_STRING* usage;
@@ -549,35 +732,25 @@ void Certificate::populateProperties(X509& cert)
                 sk_ASN1_OBJECT_value(extUsage, i))]);
         }
     }
-    keyUsage(keyUsageList);
-
-    int days = 0;
-    int secs = 0;
-
-    ASN1TimePtr epoch(ASN1_TIME_new(), ASN1_STRING_free);
-    // Set time to 00:00am GMT, Jan 1 1970; format: YYYYMMDDHHMMSSZ
-    ASN1_TIME_set_string(epoch.get(), "19700101000000Z");
-
-    static const uint64_t dayToSeconds = 24 * 60 * 60;
-    ASN1_TIME* notAfter = X509_get_notAfter(&cert);
-    ASN1_TIME_diff(&days, &secs, epoch.get(), notAfter);
-    validNotAfter((days * dayToSeconds) + secs);
+    keyUsage(keyUsageList, skipSignal);
 
-    ASN1_TIME* notBefore = X509_get_notBefore(&cert);
-    ASN1_TIME_diff(&days, &secs, epoch.get(), notBefore);
-    validNotBefore((days * dayToSeconds) + secs);
+    validNotAfter(secondsSinceEpoch(X509_get0_notAfter(&cert)), skipSignal);
+    validNotBefore(secondsSinceEpoch(X509_get0_notBefore(&cert)), skipSignal);
 }
 
-void Certificate::checkAndAppendPrivateKey(const std::string& filePath)
+internal::EVPPkeyPtr
+    Certificate::checkAndAppendPrivateKey(const std::string& installPath,
+                                          const std::string& filePath,
+                                          std::string& pem, X509& cert)
 {
-    BIOMemPtr keyBio(BIO_new(BIO_s_file()), ::BIO_free);
+    BIOMemPtr keyBio(BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size())),
+                     ::BIO_free);
     if (!keyBio)
     {
-        log<level::ERR>("Error occurred during BIO_s_file call",
+        log<level::ERR>("Error occurred during BIO_new_mem_buf call",
                         entry("FILE=%s", filePath.c_str()));
         elog<InternalFailure>();
     }
-    BIO_read_filename(keyBio.get(), filePath.c_str());
 
     EVPPkeyPtr priKey(
         PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr),
@@ -586,8 +759,8 @@ void Certificate::checkAndAppendPrivateKey(const std::string& filePath)
     {
         log<level::INFO>("Private key not present in file",
                          entry("FILE=%s", filePath.c_str()));
-        fs::path privateKeyFile = fs::path(certInstallPath).parent_path();
-        privateKeyFile = privateKeyFile / defaultPrivateKeyFileName;
+        fs::path privateKeyFile = findPrivateKeyFile(
+            fs::path(installPath).parent_path(), cert, priKey);
         if (!fs::exists(privateKeyFile))
         {
             log<level::ERR>("Private key file is not found",
@@ -595,59 +768,27 @@ void Certificate::checkAndAppendPrivateKey(const std::string& filePath)
             elog<InternalFailure>();
         }
 
-        std::ifstream privKeyFileStream;
-        std::ofstream certFileStream;
-        privKeyFileStream.exceptions(std::ifstream::failbit |
-                                     std::ifstream::badbit |
-                                     std::ifstream::eofbit);
-        certFileStream.exceptions(std::ofstream::failbit |
-                                  std::ofstream::badbit |
-                                  std::ofstream::eofbit);
-        try
-        {
-            privKeyFileStream.open(privateKeyFile);
-            certFileStream.open(filePath, std::ios::app);
-            certFileStream << std::endl; // insert line break
-            certFileStream << privKeyFileStream.rdbuf() << std::flush;
-            privKeyFileStream.close();
-            certFileStream.close();
-        }
-        catch (const std::exception& e)
-        {
-            log<level::ERR>("Failed to append private key",
-                            entry("ERR=%s", e.what()),
-                            entry("SRC=%s", privateKeyFile.c_str()),
-                            entry("DST=%s", filePath.c_str()));
-            elog<InternalFailure>();
-        }
+        // The content is installed with the key at once
+        pem += '\n';
+        pem += readFile(privateKeyFile);
     }
-}
-
-bool Certificate::compareKeys(const std::string& filePath)
-{
-    log<level::INFO>("Certificate compareKeys",
-                     entry("FILEPATH=%s", filePath.c_str()));
-    internal::X509Ptr cert(X509_new(), ::X509_free);
-    if (!cert)
+    if (!priKey)
     {
-        log<level::ERR>("Error occurred during X509_new call",
+        log<level::ERR>("Error occurred during PEM_read_bio_PrivateKey",
                         entry("FILE=%s", filePath.c_str()),
                         entry("ERRCODE=%lu", ERR_get_error()));
-        elog<InternalFailure>();
-    }
-
-    BIOMemPtr bioCert(BIO_new_file(filePath.c_str(), "rb"), ::BIO_free);
-    if (!bioCert)
-    {
-        log<level::ERR>("Error occurred during BIO_new_file call",
-                        entry("FILE=%s", filePath.c_str()));
-        elog<InternalFailure>();
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("Failed to get private key info"));
     }
+    return priKey;
+}
 
-    X509* x509 = cert.get();
-    PEM_read_bio_X509(bioCert.get(), &x509, nullptr, nullptr);
-
-    EVPPkeyPtr pubKey(X509_get_pubkey(cert.get()), ::EVP_PKEY_free);
+bool Certificate::compareKeys(const std::string& filePath, X509& cert,
+                              EVP_PKEY& priKey)
+{
+    log<level::INFO>("Certificate compareKeys",
+                     entry("FILEPATH=%s", filePath.c_str()));
+    EVPPkeyPtr pubKey(X509_get_pubkey(&cert), ::EVP_PKEY_free);
     if (!pubKey)
     {
         log<level::ERR>("Error occurred during X509_get_pubkey",
@@ -657,31 +798,10 @@ bool Certificate::compareKeys(const std::string& filePath)
             InvalidCertificate::REASON("Failed to get public key info"));
     }
 
-    BIOMemPtr keyBio(BIO_new(BIO_s_file()), ::BIO_free);
-    if (!keyBio)
-    {
-        log<level::ERR>("Error occurred during BIO_s_file call",
-                        entry("FILE=%s", filePath.c_str()));
-        elog<InternalFailure>();
-    }
-    BIO_read_filename(keyBio.get(), filePath.c_str());
-
-    EVPPkeyPtr priKey(
-        PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr),
-        ::EVP_PKEY_free);
-    if (!priKey)
-    {
-        log<level::ERR>("Error occurred during PEM_read_bio_PrivateKey",
-                        entry("FILE=%s", filePath.c_str()),
-                        entry("ERRCODE=%lu", ERR_get_error()));
-        elog<InvalidCertificateError>(
-            InvalidCertificate::REASON("Failed to get private key info"));
-    }
-
 #if (OPENSSL_VERSION_NUMBER < 0x30000000L)
-    int32_t rc = EVP_PKEY_cmp(priKey.get(), pubKey.get());
+    int32_t rc = EVP_PKEY_cmp(&priKey, pubKey.get());
 #else
-    int32_t rc = EVP_PKEY_eq(priKey.get(), pubKey.get());
+    int32_t rc = EVP_PKEY_eq(&priKey, pubKey.get());
 #endif
     if (rc != 1)
     {
@@ -698,7 +818,7 @@ void Certificate::delete_()
     manager.deleteCertificate(this);
 }
 
-std::string Certificate::getObjectPath()
+std::string Certificate::getObjectPath() const
 {
     return objectPath;
 }
@@ -1,16 +1,17 @@
 #pragma once
 
+#include "store_index.hpp"
 #include "watch.hpp"
 
 #include <openssl/ossl_typ.h>
 #include <openssl/x509.h>
 
-#include <functional>
+#include <cstdint>
 #include <memory>
 #include <sdbusplus/server/object.hpp>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 #include <xyz/openbmc_project/Certs/Certificate/server.hpp>
 #include <xyz/openbmc_project/Certs/Replace/server.hpp>
 #include <xyz/openbmc_project/Object/Delete/server.hpp>
@@ -61,13 +62,14 @@ inline constexpr CertificateType stringToCertificateType(std::string_view type)
 
 namespace internal
 {
+using CertificateProperties =
+    sdbusplus::xyz::openbmc_project::Certs::server::Certificate;
 using CertificateInterface = sdbusplus::server::object_t<
     sdbusplus::xyz::openbmc_project::Certs::server::Certificate,
     sdbusplus::xyz::openbmc_project::Certs::server::Replace,
     sdbusplus::xyz::openbmc_project::Object::server::Delete>;
-using InstallFunc = std::function<void(const std::string&)>;
-using AppendPrivKeyFunc = std::function<void(const std::string&)>;
 using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
+using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
 } // namespace internal
 
 class Manager; // Forward declaration for Certificate Manager.
@@ -103,26 +105,61 @@ class Certificate : public internal::CertificateInterface
                 const std::string& uploadPath, Watch* watch, Manager& parent,
                 bool restore);
 
+    /** @brief Constructor for the Certificate Object; a variant for
+     * certificates already validated by validate()
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] objPath - Object path to attach to
+     *  @param[in] type - Type of the certificate
+     *  @param[in] installPath - Path of the certificate to install
+     *  @param[in] uploadPath - Path of the validated certificate file
+     *  @param[in] cert - the certificate validate() returned for |uploadPath|
+     *  @param[in] pem - the content validate() returned for |uploadPath|
+     *  @param[in] watchPtr - watch on self signed certificate
+     *  @param[in] parent - the manager that owns the certificate
+     */
+    Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
+                CertificateType type, const std::string& installPath,
+                const std::string& uploadPath, X509& cert,
+                std::string_view pem, Watch* watch, Manager& parent);
+
     /** @brief Constructor for the Certificate Object; a variant for authorities
      * list install
      *  @param[in] bus - Bus to attach to.
      *  @param[in] objPath - Object path to attach to
      *  @param[in] type - Type of the certificate
      *  @param[in] installPath - Path of the certificate to install
-     *  @param[in] x509Store - an initialized X509 store used for certificate
-     * validation; Certificate object doesn't own it
+     *  @param[in] cert - the parsed x509 certificate to upload; it shall be
+     * validated with validate(X509_STORE&, X509&) beforehand
      *  @param[in] pem - Content of the certificate file to upload; it shall be
-     * a single PEM encoded x509 certificate
+     * the single PEM encoded x509 certificate |cert| was parsed from
      *  @param[in] watchPtr - watch on self signed certificate
      *  @param[in] parent - Pointer to the manager which owns the constructed
      * Certificate object
      *  @param[in] restore - the certificate is created in the restore path
+     *  @note The object stays unannounced until publish() is called, so a
+     * list that fails to install never shows up on the bus
      */
     Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
                 const CertificateType& type, const std::string& installPath,
-                X509_STORE& x509Store, const std::string& pem, Watch* watchPtr,
+                X509& cert, std::string_view pem, Watch* watchPtr,
                 Manager& parent, bool restore);
 
+    /** @brief Constructor for the Certificate Object; a variant restoring an
+     * unchanged certificate file from the store index, without parsing nor
+     * validating it again. The caller checks isRestorableFromIndex() first.
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] objPath - Object path to attach to
+     *  @param[in] type - Type of the certificate
+     *  @param[in] installPath - Path of the certificate to install
+     *  @param[in] indexEntry - the index entry of the installed file
+     *  @param[in] watchPtr - watch on self signed certificate
+     *  @param[in] parent - the manager that owns the certificate
+     */
+    Certificate(sdbusplus::bus_t& bus, const std::string& objPath,
+                CertificateType type, const std::string& installPath,
+                const StoreIndexEntry& indexEntry, Watch* watch,
+                Manager& parent);
+
     /** @brief Validate and Replace/Install the certificate file
      *  Install/Replace the existing certificate file with another
      *  (possibly CA signed) Certificate file.
@@ -131,15 +168,63 @@ class Certificate : public internal::CertificateInterface
      */
     void install(const std::string& filePath, bool restore);
 
-    /** @brief Validate and Replace/Install the certificate file
+    /** @brief Replace/Install the already validated certificate
      *  Install/Replace the existing certificate file with another
      *  (possibly CA signed) Certificate file.
+     *  @param[in] cert - the parsed x509 certificate; it shall be validated
+     * with validate(X509_STORE&, X509&) beforehand
+     *  @param[in] pem - a string buffer which stores the PEM encoded |cert|.
+     *  @param[in] restore - the certificate is created in the restore path
+     */
+    void install(X509& cert, std::string_view pem, bool restore);
+
+    /** @brief Validate and Replace/Install the certificate from its content,
+     * e.g. read from a file descriptor the client passed
+     *  @param[in] pem - Content of the certificate file.
+     */
+    void installContent(std::string pem);
+
+    /** @brief Validate an authorities list certificate
+     *  Concurrent calls sharing the same store are safe.
      *  @param[in] x509Store - an initialized X509 store used for certificate
-     * validation; Certificate object doesn't own it
-     *  @param[in] pem - a string buffer which stores a PEM encoded certificate.
+     * validation
+     *  @param[in] cert - the parsed x509 certificate.
+     */
+    static void validate(X509_STORE& x509Store, X509& cert);
+
+    /** @brief Validate the certificate file before its install
+     *  It doesn't touch any Certificate object nor any file, so it is safe to
+     *  run it off the event loop. The file is read once; server and client
+     *  certificates lacking a private key get the existing one appended to
+     *  the content to install. With the shared authority store, server and
+     *  client certificates installed anew must chain up to one of the
+     *  installed authorities.
+     *  @param[in] type - Type of the certificate
+     *  @param[in] installPath - Path of the certificate to install
+     *  @param[in] certSrcFilePath - Certificate file path.
+     *  @param[out] pem - The content to install.
+     *  @param[in] restore - the certificate is created in the restore path
+     *  @return the parsed and validated certificate
+     */
+    static internal::X509Ptr validate(CertificateType type,
+                                      const std::string& installPath,
+                                      const std::string& certSrcFilePath,
+                                      std::string& pem, bool restore);
+
+    /** @brief Validate the content of a certificate file before its install;
+     * validate() once the file is read
+     *  @param[in] type - Type of the certificate
+     *  @param[in] installPath - Path of the certificate to install
+     *  @param[in] source - Where the content comes from, for the logs.
+     *  @param[in,out] pem - The content of the file, then the content to
+     * install.
      *  @param[in] restore - the certificate is created in the restore path
+     *  @return the parsed and validated certificate
      */
-    void install(X509_STORE& x509Store, const std::string& pem, bool restore);
+    static internal::X509Ptr validateContent(CertificateType type,
+                                             const std::string& installPath,
+                                             const std::string& source,
+                                             std::string& pem, bool restore);
 
     /** @brief Validate certificate and replace the existing certificate
      *  @param[in] filePath - Certificate file path.
@@ -150,6 +235,36 @@ class Certificate : public internal::CertificateInterface
      */
     void populateProperties();
 
+    /** @brief Whether the InterfacesAdded signal of the object waits for its
+     * properties to be built
+     */
+    bool isAnnouncementPending() const;
+
+    /** @brief Build the properties deferred at construction, then emit the
+     * InterfacesAdded signal
+     */
+    void announce();
+
+    /**
+     * @brief Emit the InterfacesAdded signal; if the properties are deferred,
+     * leave it to the manager once the event loop is idle
+     */
+    void publish();
+
+    /* Properties deferred at construction are built on first read */
+    using internal::CertificateProperties::certificateString;
+    using internal::CertificateProperties::issuer;
+    using internal::CertificateProperties::keyUsage;
+    using internal::CertificateProperties::subject;
+    using internal::CertificateProperties::validNotAfter;
+    using internal::CertificateProperties::validNotBefore;
+    std::string certificateString() const override;
+    std::string issuer() const override;
+    std::vector<std::string> keyUsage() const override;
+    std::string subject() const override;
+    uint64_t validNotAfter() const override;
+    uint64_t validNotBefore() const override;
+
     /**
      * @brief Obtain certificate ID.
      *
@@ -158,49 +273,77 @@ class Certificate : public internal::CertificateInterface
     std::string getCertId() const;
 
     /**
-     * @brief Check if provided certificate is the same as the current one.
+     * @brief Obtain the SHA-256 fingerprint of the certificate.
      *
-     * @param[in] certPath - File path for certificate to check.
+     * @return Certificate fingerprint.
+     */
+    const std::string& getFingerprint() const;
+
+    /**
+     * @brief Obtain the parsed certificate, cached at install.
      *
-     * @return Checking result. Return true if certificates are the same,
-     *         false if not.
+     * @return The certificate; null if it was restored from the store index
+     * and hasn't been parsed since.
      */
-    bool isSame(const std::string& certPath);
+    X509* getX509() const;
 
     /**
-     * @brief Update certificate storage.
+     * @brief Obtain the PEM the authority was installed or restored from,
+     * without reading its file; empty for the other types, whose file holds
+     * the private key too.
+     *
+     * @return Certificate PEM.
      */
-    void storageUpdate();
+    const std::string& getPem() const;
 
     /**
-     * @brief Delete the certificate
+     * @brief Obtain the OpenSSL subject name hash of the certificate, the
+     * base name of its hash.N symbolic link in the authority store.
+     *
+     * @return Certificate subject name hash.
      */
-    void delete_() override;
+    const std::string& getSubjectNameHash() const;
 
     /**
-     * @brief Generate file name which is unique in the provided directory.
+     * @brief Obtain the expiration time of the certificate, without building
+     * the properties deferred at construction.
      *
-     * @param[in] directoryPath - Directory path.
+     * @return ValidNotAfter, in seconds since epoch.
+     */
+    uint64_t getExpirationTime() const;
+
+    /**
+     * @brief Check if provided certificate is the same as the current one.
      *
-     * @return File path.
+     * The check only uses the data cached at install time; the installed
+     * certificate file isn't read again.
+     *
+     * @param[in] cert - Already parsed certificate to check.
+     *
+     * @return Checking result. Return true if certificates are the same,
+     *         false if not.
      */
-    static std::string generateUniqueFilePath(const std::string& directoryPath);
+    bool isSame(X509& cert) const;
 
     /**
-     * @brief Copies the certificate from sourceFilePath to installFilePath
+     * @brief Delete the certificate
+     */
+    void delete_() override;
+
+    /**
+     * @brief Create an empty file of unique name in the provided directory,
+     * reserving the name.
      *
-     * @param[in] sourceFilePath - Path to the source file.
-     * @param[in] certFilePath - Path to the destination file.
+     * @param[in] directoryPath - Directory path.
      *
-     * @return void
+     * @return File path.
      */
-    static void copyCertificate(const std::string& certSrcFilePath,
-                                const std::string& certFilePath);
+    static std::string generateUniqueFilePath(const std::string& directoryPath);
 
     /**
      * @brief Returns the associated dbus object path.
      */
-    std::string getObjectPath();
+    std::string getObjectPath() const;
 
     /**
      * @brief Returns the associated cert file path.
@@ -226,44 +369,69 @@ class Certificate : public internal::CertificateInterface
      */
     void populateProperties(X509& cert);
 
-    /** @brief Check and append private key to the certificate file
-     *         If private key is not present in the certificate file append the
-     *         certificate file with private key existing in the system.
-     *  @param[in] filePath - Certificate and key full file path.
-     *  @return void.
+    /**
+     * @brief Set the certificate properties from given certificate object
+     *
+     * @param[in] cert The given certificate object
+     * @param[in] skipSignal Whether to skip the PropertiesChanged signals
+     *
+     * @return void
      */
-    void checkAndAppendPrivateKey(const std::string& filePath);
+    void setProperties(X509& cert, bool skipSignal);
 
-    /** @brief Public/Private key compare function.
-     *         Comparing private key against certificate public key
-     *         from input .pem file.
-     *  @param[in] filePath - Certificate and key full file path.
-     *  @return Return true if Key compare is successful,
-     *          false if not
+    /**
+     * @brief Build the properties deferred at construction, if any
      */
-    bool compareKeys(const std::string& filePath);
+    void materializeProperties() const;
 
     /**
-     * @brief Generate authority certificate file path corresponding with
-     * OpenSSL requirements.
-     *
-     * Prepare authority certificate file path for provided certificate.
-     * OpenSSL puts some restrictions on the certificate file name pattern.
-     * Certificate full file name needs to consists of basic file name which
-     * is certificate subject name hash and file name extension which is an
-     * integer. More over, certificates files names extensions must be
-     * consecutive integer numbers in case many certificates with the same
-     * subject name.
-     * https://www.boost.org/doc/libs/1_69_0/doc/html/boost_asio/reference/ssl__context/add_verify_path.html
-     * https://www.openssl.org/docs/man1.0.2/man3/SSL_CTX_load_verify_locations.html
+     * @brief Keep a reference to the given certificate object together with
+     * the identifiers derived from it
      *
-     * @param[in] certSrcFilePath - Certificate source file path.
-     * @param[in] certDstDirPath - Certificate destination directory path.
+     * @param[in] cert The given certificate object
      *
-     * @return Authority certificate file path.
+     * @return void
+     */
+    void cacheCertificate(X509& cert);
+
+    /** @brief Install the already validated certificate file
+     *  @param[in] certSrcFilePath - Certificate file path.
+     *  @param[in] cert - the certificate validate() returned for the file
+     *  @param[in] pem - the content validate() returned for the file
+     *  @return void.
+     */
+    void commit(const std::string& certSrcFilePath, X509& cert,
+                std::string_view pem);
+
+    /** @brief Ignore the changes of the certificate watch, if any, while the
+     *  returned suppression lives
      */
-    std::string generateAuthCertFileX509Path(const std::string& certSrcFilePath,
-                                             const std::string& certDstDirPath);
+    Watch::Suppression suppressWatch();
+
+    /** @brief Check and append private key to the certificate file content
+     *         If private key is not present in the content append the
+     *         private key existing in the system to it.
+     *  @param[in] installPath - Path of the certificate to install.
+     *  @param[in] filePath - Certificate and key full file path.
+     *  @param[in,out] pem - Content of the file.
+     *  @param[in] cert - The certificate of the file.
+     *  @return the private key of the content
+     */
+    static internal::EVPPkeyPtr
+        checkAndAppendPrivateKey(const std::string& installPath,
+                                 const std::string& filePath, std::string& pem,
+                                 X509& cert);
+
+    /** @brief Public/Private key compare function.
+     *         Comparing private key against certificate public key.
+     *  @param[in] filePath - Certificate and key full file path.
+     *  @param[in] cert - The certificate of the file.
+     *  @param[in] priKey - The private key of the file.
+     *  @return Return true if Key compare is successful,
+     *          false if not
+     */
+    static bool compareKeys(const std::string& filePath, X509& cert,
+                            EVP_PKEY& priKey);
 
     /**
      * @brief Generate authority certificate file path based on provided
@@ -271,7 +439,8 @@ class Certificate : public internal::CertificateInterface
      *
      * @param[in] certSrcFilePath - Certificate source file path.
      *
-     * @return Authority certificate file path.
+     * @return Authority certificate file path; empty if the certificate
+     * needs a new file.
      */
     std::string generateAuthCertFilePath(const std::string& certSrcFilePath);
 
@@ -285,9 +454,6 @@ class Certificate : public internal::CertificateInterface
      */
     std::string generateCertFilePath(const std::string& certSrcFilePath);
 
-    /** @brief Type specific function pointer map */
-    std::unordered_map<CertificateType, internal::InstallFunc> typeFuncMap;
-
     /** @brief object path */
     std::string objectPath;
 
@@ -297,16 +463,24 @@ class Certificate : public internal::CertificateInterface
     /** @brief Stores certificate ID */
     std::string certId;
 
+    /** @brief Stores certificate subject name hash */
+    std::string subjectNameHash;
+
+    /** @brief Stores certificate SHA-256 fingerprint */
+    std::string fingerprint;
+
+    /** @brief Reference to the installed x509 certificate */
+    internal::X509Ptr x509{nullptr, ::X509_free};
+
+    /** @brief PEM the authority was installed or restored from */
+    std::string installedPem;
+
     /** @brief Stores certificate file path */
     std::string certFilePath;
 
     /** @brief Certificate file installation path */
     std::string certInstallPath;
 
-    /** @brief Type specific function pointer map for appending private key */
-    std::unordered_map<CertificateType, internal::AppendPrivKeyFunc>
-        appendKeyMap;
-
     /** @brief Certificate file create/update watch
      * Note that Certificate object doesn't own the pointer
      */
@@ -314,6 +488,12 @@ class Certificate : public internal::CertificateInterface
 
     /** @brief Reference to Certificate Manager */
     Manager& manager;
+
+    /** @brief Whether the InterfacesAdded signal was emitted */
+    bool announced = false;
+
+    /** @brief Whether the properties are still to be built from |x509| */
+    mutable bool propertiesPending = false;
 };
 
 } // namespace phosphor::certs
@@ -2,10 +2,16 @@
 
 #include "certs_manager.hpp"
 
+#include "authority_store.hpp"
+#include "file_utils.hpp"
+#include "store_index.hpp"
 #include "x509_utils.hpp"
 
+#include <fcntl.h>
 #include <openssl/asn1.h>
+#include <openssl/bio.h>
 #include <openssl/bn.h>
+#include <openssl/buffer.h>
 #include <openssl/ec.h>
 #include <openssl/evp.h>
 #include <openssl/obj_mac.h>
@@ -14,18 +20,22 @@
 #include <openssl/pem.h>
 #include <openssl/rsa.h>
 #include <openssl/x509v3.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <systemd/sd-event.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <array>
 #include <cerrno>
 #include <chrono>
-#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/lg2.hpp>
@@ -34,7 +44,8 @@
 #include <sdbusplus/exception.hpp>
 #include <sdbusplus/message.hpp>
 #include <sdeventplus/source/base.hpp>
-#include <sdeventplus/source/child.hpp>
+#include <stdexcept>
+#include <unordered_set>
 #include <utility>
 #include <xyz/openbmc_project/Certs/error.hpp>
 #include <xyz/openbmc_project/Common/error.hpp>
@@ -64,6 +75,7 @@ using Argument =
 
 // RAII support for openSSL functions.
 using X509ReqPtr = std::unique_ptr<X509_REQ, decltype(&::X509_REQ_free)>;
+using BIOMemPtr = std::unique_ptr<BIO, decltype(&::BIO_free)>;
 using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
 using BignumPtr = std::unique_ptr<BIGNUM, decltype(&::BN_free)>;
 using X509StorePtr = std::unique_ptr<X509_STORE, decltype(&::X509_STORE_free)>;
@@ -83,63 +95,111 @@ constexpr int supportedKeyBitLength = 2048;
 constexpr int defaultKeyBitLength = 2048;
 // secp224r1 is equal to RSA 2048 KeyBitLength. Refer RFC 5349
 constexpr auto defaultKeyCurveID = "secp224r1";
-// PEM certificate block markers, defined in go/rfc/7468.
-constexpr std::string_view beginCertificate = "-----BEGIN CERTIFICATE-----";
-constexpr std::string_view endCertificate = "-----END CERTIFICATE-----";
 
 /**
- * @brief Splits the given authorities list file and returns an array of
- * individual PEM encoded x509 certificate.
+ * @brief Read the certificate file a client passed as a descriptor
  *
- * @param[in] sourceFilePath - Path to the authorities list file.
+ * @param[in] fd - The descriptor of a regular file, e.g. a memfd.
  *
- * @return An array of individual PEM encoded x509 certificate
+ * @return the content of the file
  */
-std::vector<std::string> splitCertificates(const std::string& sourceFilePath)
+std::string readUpload(int fd)
 {
-    std::ifstream inputCertFileStream;
-    inputCertFileStream.exceptions(
-        std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
-
-    std::stringstream pemStream;
-    std::vector<std::string> certificatesList;
     try
     {
-        inputCertFileStream.open(sourceFilePath);
-        pemStream << inputCertFileStream.rdbuf();
-        inputCertFileStream.close();
+        return readFd(fd, maxUploadSize);
     }
-    catch (const std::exception& e)
+    catch (const std::invalid_argument&)
     {
-        log<level::ERR>("Failed to read certificates list",
-                        entry("ERR=%s", e.what()),
-                        entry("SRC=%s", sourceFilePath.c_str()));
-        elog<InternalFailure>();
+        // The event loop must not wait for a pipe or a socket to be closed
+        elog<InvalidArgument>(Argument::ARGUMENT_NAME("FD"),
+                              Argument::ARGUMENT_VALUE("not a regular file"));
     }
-    std::string pem = pemStream.str();
-    size_t begin = 0;
-    // |begin| points to the current start position for searching the next
-    // |beginCertificate| block. When we find the beginning of the certificate,
-    // we extract the content between the beginning and the end of the current
-    // certificate. And finally we move |begin| to the end of the current
-    // certificate to start searching the next potential certificate.
-    for (begin = pem.find(beginCertificate, begin); begin != std::string::npos;
-         begin = pem.find(beginCertificate, begin))
-    {
-        size_t end = pem.find(endCertificate, begin);
-        if (end == std::string::npos)
+    catch (const std::length_error&)
+    {
+        elog<NotAllowed>(NotAllowedReason("Uploaded file is too large"));
+    }
+}
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The mapping is released when the object goes out of scope; string views
+ * returned by view() must not outlive it. Only for the files of the store:
+ * reads of a mapped file truncated meanwhile fault with SIGBUS, and the
+ * files of the clients may be truncated at any time.
+ */
+class ReadOnlyFileMapping
+{
+  public:
+    ReadOnlyFileMapping() = delete;
+    ReadOnlyFileMapping(const ReadOnlyFileMapping&) = delete;
+    ReadOnlyFileMapping& operator=(const ReadOnlyFileMapping&) = delete;
+    ReadOnlyFileMapping(ReadOnlyFileMapping&&) = delete;
+    ReadOnlyFileMapping& operator=(ReadOnlyFileMapping&&) = delete;
+
+    /** @brief Maps the file at |filePath|
+     *  @param[in] filePath - Path of the file to map.
+     */
+    explicit ReadOnlyFileMapping(const std::string& filePath)
+    {
+        int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
         {
-            log<level::ERR>(
-                "invalid PEM contains a BEGIN identifier without an END");
-            elog<InvalidCertificate>(InvalidCertificateReason(
-                "invalid PEM contains a BEGIN identifier without an END"));
+            log<level::ERR>("Failed to open certificates list",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("SRC=%s", filePath.c_str()));
+            elog<InternalFailure>();
+        }
+        struct stat st
+        {};
+        if (fstat(fd, &st) == -1)
+        {
+            int error = errno;
+            close(fd);
+            log<level::ERR>("Failed to stat certificates list",
+                            entry("ERR=%s", std::strerror(error)),
+                            entry("SRC=%s", filePath.c_str()));
+            elog<InternalFailure>();
+        }
+        size = static_cast<size_t>(st.st_size);
+        // mmap() refuses zero length mappings; an empty file is an empty view
+        if (size > 0)
+        {
+            void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                int error = errno;
+                close(fd);
+                log<level::ERR>("Failed to map certificates list",
+                                entry("ERR=%s", std::strerror(error)),
+                                entry("SRC=%s", filePath.c_str()));
+                elog<InternalFailure>();
+            }
+            data = static_cast<const char*>(addr);
         }
-        end += endCertificate.size();
-        certificatesList.emplace_back(pem.substr(begin, end - begin));
-        begin = end;
+        // The mapping stays valid after the descriptor is closed
+        close(fd);
     }
-    return certificatesList;
-}
+
+    ~ReadOnlyFileMapping()
+    {
+        if (data != nullptr)
+        {
+            munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    /** @brief Returns the content of the mapped file */
+    std::string_view view() const
+    {
+        return {data, size};
+    }
+
+  private:
+    const char* data = nullptr;
+    size_t size = 0;
+};
 
 } // namespace
 
@@ -149,6 +209,8 @@ Manager::Manager(sdbusplus::bus_t& bus, sdeventplus::Event& event,
     internal::ManagerInterface(bus, path),
     bus(bus), event(event), objectPath(path), certType(type),
     unitToRestart(std::move(unit)), certInstallPath(std::move(installPath)),
+    metrics(bus, path), expiryScheduler(bus, event, path),
+    fdInstall(bus, path, *this), reloadControl(bus, path, *this),
     certParentInstallPath(fs::path(certInstallPath).parent_path())
 {
     try
@@ -190,10 +252,30 @@ Manager::Manager(sdbusplus::bus_t& bus, sdeventplus::Event& event,
         if (certType != CertificateType::authority)
         {
             createRSAPrivateKeyFile();
+            // CSR objects don't outlive the service; neither do their keys
+            std::error_code ec;
+            fs::remove_all(certParentInstallPath / defaultCSRDirName, ec);
+            // Have the EC key of the first CSR ready as well
+            ecKeyPoolCurves.insert(getECCurveNid(""));
+            scheduleIdleWork();
+        }
+
+        if (certType == CertificateType::authority)
+        {
+            // Next to the store, which stays a directory of certificates
+            fs::path storeDir = fs::path(certInstallPath).lexically_normal();
+            if (storeDir.filename().empty())
+            {
+                storeDir = storeDir.parent_path();
+            }
+            trustSnapshot = std::make_unique<TrustSnapshot>(
+                bus, path, storeDir.string() + defaultTrustSnapshotSuffix);
         }
 
         // restore any existing certificates
         createCertificates();
+        updateTrustSnapshot();
+        shareAuthorities();
 
         // watch is not required for authority certificates
         if (certType != CertificateType::authority)
@@ -201,6 +283,7 @@ Manager::Manager(sdbusplus::bus_t& bus, sdeventplus::Event& event,
             // watch for certificate file create/replace
             certWatchPtr = std::make_unique<
                 Watch>(event, certInstallPath, [this]() {
+                Metrics::Timer timer(metrics, Operation::watchCallback);
                 try
                 {
                     // if certificate file existing update it
@@ -208,7 +291,17 @@ Manager::Manager(sdbusplus::bus_t& bus, sdeventplus::Event& event,
                     {
                         log<level::INFO>("Inotify callback to update "
                                          "certificate properties");
-                        installedCerts[0]->populateProperties();
+                        unindexCertificate(*installedCerts[0]);
+                        try
+                        {
+                            installedCerts[0]->populateProperties();
+                        }
+                        catch (...)
+                        {
+                            indexCertificate(*installedCerts[0]);
+                            throw;
+                        }
+                        indexCertificate(*installedCerts[0]);
                     }
                     else
                     {
@@ -226,6 +319,15 @@ Manager::Manager(sdbusplus::bus_t& bus, sdeventplus::Event& event,
                     commit<InvalidCertificate>();
                 }
             });
+
+            std::string rsaPrivateKeyFile =
+                certParentInstallPath / defaultRSAPrivateKeyFileName;
+            rsaKeyWatchPtr =
+                std::make_unique<Watch>(event, rsaPrivateKeyFile, [this]() {
+                    Metrics::Timer timer(metrics, Operation::watchCallback);
+                    std::lock_guard lock(rsaKeyMutex);
+                    rsaKey.reset();
+                });
         }
         else
         {
@@ -262,17 +364,76 @@ Manager::Manager(sdbusplus::bus_t& bus, sdeventplus::Event& event,
     }
 }
 
-std::string Manager::install(const std::string filePath)
+Manager::~Manager()
+{
+    // reloadOrReset is virtual, so the owner had to flush the batching
+    // window already
+    if (reloadPending)
+    {
+        log<level::WARNING>("Certificate manager destroyed before the unit "
+                            "was reloaded",
+                            entry("UNIT=%s", unitToRestart.c_str()));
+    }
+    // The replies of the reloads can't be handled anymore
+    for (auto& done : std::exchange(reloadWaiters, {}))
+    {
+        done(false);
+    }
+
+    // The changes the idle work didn't get to yet
+    if (storeIndexOutdated)
+    {
+        try
+        {
+            updateStoreIndex();
+        }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>("Failed to write store index",
+                            entry("ERR=%s", e.what()));
+        }
+    }
+
+    // The other managers of the process outlive these authorities
+    try
+    {
+        AuthorityStore::getInstance().remove(std::vector<std::string>(
+            sharedAuthorities.begin(), sharedAuthorities.end()));
+    }
+    catch (const InternalFailure& e)
+    {
+        commit<InternalFailure>();
+    }
+}
+
+void Manager::checkInstallAllowed() const
 {
-    if (certType != CertificateType::authority && !installedCerts.empty())
+    // Installs still in progress count as installed certificates
+    size_t numInstalling = numInstallsInProgress();
+    if (certType != CertificateType::authority &&
+        (!installedCerts.empty() || numInstalling > 0))
     {
         elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
     }
     else if (certType == CertificateType::authority &&
-             installedCerts.size() >= maxNumAuthorityCertificates)
+             installedCerts.size() + numInstalling >=
+                 maxNumAuthorityCertificates)
     {
         elog<NotAllowed>(NotAllowedReason("Certificates limit reached"));
     }
+}
+
+std::string Manager::install(const std::string filePath)
+{
+    Metrics::Timer timer(metrics, Operation::install);
+    checkInstallAllowed();
+
+    if (isInstallAsync())
+    {
+        // The caller may remove the file as soon as the call returns;
+        // validate its content instead
+        return installAsync(readFile(filePath));
+    }
 
     std::string certObjectPath;
     if (isCertificateUnique(filePath))
@@ -281,7 +442,11 @@ std::string Manager::install(const std::string filePath)
         installedCerts.emplace_back(std::make_unique<Certificate>(
             bus, certObjectPath, certType, certInstallPath, filePath,
             certWatchPtr.get(), *this, /*restore=*/false));
-        reloadOrReset(unitToRestart);
+        indexCertificate(*installedCerts.back());
+        linkCertificate(*installedCerts.back());
+        authoritiesListInSync = false;
+        saveStoreIndex();
+        requestReload();
         certIdCounter++;
     }
     else
@@ -292,8 +457,138 @@ std::string Manager::install(const std::string filePath)
     return certObjectPath;
 }
 
+std::string Manager::installFd(int fd)
+{
+    Metrics::Timer timer(metrics, Operation::install);
+    checkInstallAllowed();
+    std::string pem = readUpload(fd);
+
+    if (isInstallAsync())
+    {
+        return installAsync(std::move(pem));
+    }
+
+    internal::X509Ptr cert = Certificate::validateContent(
+        certType, certInstallPath, "<fd>", pem, /*restore=*/false);
+    if (!isCertificateUnique(*cert))
+    {
+        elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
+    }
+    std::string certObjectPath =
+        objectPath + '/' + std::to_string(certIdCounter);
+    installedCerts.emplace_back(std::make_unique<Certificate>(
+        bus, certObjectPath, certType, certInstallPath, std::string(), *cert,
+        pem, certWatchPtr.get(), *this));
+    indexCertificate(*installedCerts.back());
+    linkCertificate(*installedCerts.back());
+    authoritiesListInSync = false;
+    saveStoreIndex();
+    requestReload();
+    certIdCounter++;
+    return certObjectPath;
+}
+
+std::string Manager::installAsync(std::string pem)
+{
+    if (!isCertificateUnique(*parseCert(pem)))
+    {
+        elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
+    }
+
+    // Results of finished installs were already published
+    std::erase_if(installJobs,
+                  [](const auto& job) { return !job.second->isInProgress(); });
+
+    std::string certObjectPath =
+        objectPath + '/' + std::to_string(certIdCounter++);
+    installJobs.emplace(certObjectPath, std::make_unique<InstallJob>(
+                                            bus, certObjectPath.c_str()));
+    log<level::INFO>("Certificate install queued",
+                     entry("OBJPATH=%s", certObjectPath.c_str()));
+
+    auto validated = std::make_shared<internal::X509Ptr>(nullptr, ::X509_free);
+    auto content = std::make_shared<std::string>(std::move(pem));
+    getWorkerPool().submit(
+        [type = certType, installPath = certInstallPath, validated,
+         content]() {
+            *validated = Certificate::validateContent(
+                type, installPath, "<upload>", *content, /*restore=*/false);
+        },
+        [this, certObjectPath, validated,
+         content](std::exception_ptr error) {
+            auto job = installJobs.find(certObjectPath);
+            try
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+                // Another install may have added the same certificate while
+                // this one was validated
+                if (!isCertificateUnique(**validated))
+                {
+                    elog<NotAllowed>(
+                        NotAllowedReason("Certificate already exist"));
+                }
+                installedCerts.emplace_back(std::make_unique<Certificate>(
+                    bus, certObjectPath, certType, certInstallPath,
+                    std::string(), **validated, *content,
+                    certWatchPtr.get(), *this));
+                indexCertificate(*installedCerts.back());
+                linkCertificate(*installedCerts.back());
+                authoritiesListInSync = false;
+                saveStoreIndex();
+                requestReload();
+                if (job != installJobs.end())
+                {
+                    job->second->complete();
+                }
+            }
+            catch (const std::exception& e)
+            {
+                log<level::ERR>("Asynchronous certificate install failed",
+                                entry("OBJPATH=%s", certObjectPath.c_str()),
+                                entry("ERR=%s", e.what()));
+                if (job != installJobs.end())
+                {
+                    job->second->fail();
+                }
+            }
+        });
+    return certObjectPath;
+}
+
+WorkerPool& Manager::getWorkerPool()
+{
+    if (!workerPool)
+    {
+        workerPool = std::make_unique<WorkerPool>(event, numValidationThreads);
+    }
+    return *workerPool;
+}
+
+size_t Manager::numInstallsInProgress() const
+{
+    return std::count_if(
+        installJobs.begin(), installJobs.end(),
+        [](const auto& job) { return job.second->isInProgress(); });
+}
+
 std::vector<sdbusplus::message::object_path>
     Manager::installAll(const std::string filePath)
+{
+    Metrics::Timer timer(metrics, Operation::installAll);
+    return installAuthoritiesList(filePath, /*replace=*/false);
+}
+
+std::vector<sdbusplus::message::object_path> Manager::installAllFd(int fd)
+{
+    Metrics::Timer timer(metrics, Operation::installAll);
+    checkAuthoritiesListAllowed(/*replace=*/false);
+    return installAuthorities(readUpload(fd), "<fd>", /*replace=*/false);
+}
+
+void Manager::checkAuthoritiesListAllowed(bool replace) const
 {
     if (certType != CertificateType::authority)
     {
@@ -302,12 +597,18 @@ std::vector<sdbusplus::message::object_path>
                              "Authority certificates"));
     }
 
-    if (!installedCerts.empty())
+    if (!replace && !installedCerts.empty())
     {
         elog<NotAllowed>(NotAllowedReason(
             "There are already root certificates; Call DeleteAll then "
             "InstallAll, or use ReplaceAll"));
     }
+}
+
+std::vector<sdbusplus::message::object_path>
+    Manager::installAuthoritiesList(const std::string& filePath, bool replace)
+{
+    checkAuthoritiesListAllowed(replace);
 
     fs::path sourceFile(filePath);
     if (!fs::exists(sourceFile))
@@ -315,40 +616,89 @@ std::vector<sdbusplus::message::object_path>
         log<level::ERR>("File is Missing", entry("FILE=%s", filePath.c_str()));
         elog<InternalFailure>();
     }
-    std::vector<std::string> authorities = splitCertificates(sourceFile);
+    // The client owns the file, so it's read rather than mapped; the copy
+    // backs every PEM view until the install completes
+    std::string content = readFile(filePath);
+    return installAuthorities(content, filePath, replace);
+}
+
+std::vector<sdbusplus::message::object_path>
+    Manager::installAuthorities(std::string_view content,
+                                const std::string& source, bool replace)
+{
+    std::vector<std::string_view> authorities = splitCertificates(content);
     if (authorities.size() > maxNumAuthorityCertificates)
     {
         elog<NotAllowed>(NotAllowedReason("Certificates limit reached"));
     }
+    if (authorities.empty())
+    {
+        log<level::ERR>("No certificate found in the authorities list",
+                        entry("FILE=%s", source.c_str()));
+        elog<InvalidCertificate>(
+            InvalidCertificateReason("Invalid certificate file format"));
+    }
+
+    // Parse every certificate once; the parsed objects are used both to
+    // build the validation store and to install the certificates
+    std::vector<internal::X509Ptr> parsedAuthorities;
+    parsedAuthorities.reserve(authorities.size());
+    for (const auto& authority : authorities)
+    {
+        parsedAuthorities.emplace_back(parseCert(authority));
+    }
 
-    log<level::INFO>("Starts authority list install");
+    log<level::DEBUG>("Starts authority list install",
+                      entry("FILE=%s", source.c_str()),
+                      entry("NUM=%zu", authorities.size()));
 
     fs::path authorityStore(certInstallPath);
     fs::path authoritiesListFile =
         authorityStore / defaultAuthoritiesListFileName;
 
+    // Entries are independent of each other; validate them in parallel
+    // against the shared store before anything gets installed
+    X509StorePtr x509Store = getX509Store(parsedAuthorities);
+    std::vector<WorkerPool::Work> validations;
+    validations.reserve(parsedAuthorities.size());
+    for (const auto& authority : parsedAuthorities)
+    {
+        validations.emplace_back([&x509Store, &authority]() {
+            Certificate::validate(*x509Store, *authority);
+        });
+    }
+    if (validations.size() > 1)
+    {
+        getWorkerPool().runAll(std::move(validations));
+    }
+    else
+    {
+        validations.front()();
+    }
+
     // Atomically install all the certificates
-    fs::path tempPath = Certificate::generateUniqueFilePath(authorityStore);
-    fs::create_directory(tempPath);
-    // Copies the authorities list
-    Certificate::copyCertificate(sourceFile,
-                                 tempPath / defaultAuthoritiesListFileName);
+    fs::path tempPath = createUniqueDirectory(authorityStore);
+    // Writes the authorities list in one go
+    writeFileAtomically(tempPath / defaultAuthoritiesListFileName, content);
     std::vector<std::unique_ptr<Certificate>> tempCertificates;
     uint64_t tempCertIdCounter = certIdCounter;
-    X509StorePtr x509Store = getX509Store(sourceFile);
-    for (const auto& authority : authorities)
+    for (size_t i = 0; i < authorities.size(); ++i)
     {
         std::string certObjectPath =
             objectPath + '/' + std::to_string(tempCertIdCounter);
         tempCertificates.emplace_back(std::make_unique<Certificate>(
-            bus, certObjectPath, certType, tempPath, *x509Store, authority,
-            certWatchPtr.get(), *this, /*restore=*/false));
+            bus, certObjectPath, certType, tempPath, *parsedAuthorities[i],
+            authorities[i], certWatchPtr.get(), *this, /*restore=*/false));
         tempCertIdCounter++;
     }
 
-    // We are good now, issue swap
-    installedCerts = std::move(tempCertificates);
+    // We are good now, issue swap; the replaced certificates take their
+    // files along, the authorities list gets overwritten below
+    std::vector<std::unique_ptr<Certificate>> replacedCertificates =
+        std::exchange(installedCerts, std::move(tempCertificates));
     certIdCounter = tempCertIdCounter;
+    replacedCertificates.clear();
+    reindexCertificates();
     // Rename all the certificates including the authorities list
     for (const fs::path& f : fs::directory_iterator(tempPath))
     {
@@ -358,45 +708,64 @@ std::vector<sdbusplus::message::object_path>
         }
         fs::rename(/*from=*/f, /*to=*/certInstallPath / f.filename());
     }
-    // Update file locations and create symbol links
+    // Update file locations and create symbol links, dropping those of the
+    // replaced certificates
     for (const auto& cert : installedCerts)
     {
         cert->setCertInstallPath(certInstallPath);
         cert->setCertFilePath(certInstallPath /
                               fs::path(cert->getCertFilePath()).filename());
-        cert->storageUpdate();
     }
+    storageUpdate();
     // Remove the temporary folder
     fs::remove_all(tempPath);
+    authoritiesListInSync = true;
+    saveStoreIndex();
 
+    // Only the committed list shows up on the bus, in one go
     std::vector<sdbusplus::message::object_path> objects;
     for (const auto& certificate : installedCerts)
     {
+        certificate->publish();
         objects.emplace_back(certificate->getObjectPath());
     }
 
-    log<level::INFO>("Finishes authority list install; reload units starts");
-    reloadOrReset(unitToRestart);
+    log<level::INFO>("Finishes authority list install; reload units starts",
+                     entry("FILE=%s", source.c_str()),
+                     entry("NUM=%zu", objects.size()),
+                     entry("REPLACE=%d", replace));
+    requestReload();
     return objects;
 }
 
 std::vector<sdbusplus::message::object_path>
     Manager::replaceAll(std::string filePath)
 {
-    installedCerts.clear();
-    certIdCounter = 1;
-    storageUpdate();
-    return installAll(std::move(filePath));
+    Metrics::Timer timer(metrics, Operation::replaceAll);
+    // The current certificates stay until the new list is validated and
+    // installed
+    return installAuthoritiesList(filePath, /*replace=*/true);
+}
+
+std::vector<sdbusplus::message::object_path> Manager::replaceAllFd(int fd)
+{
+    Metrics::Timer timer(metrics, Operation::replaceAll);
+    checkAuthoritiesListAllowed(/*replace=*/true);
+    return installAuthorities(readUpload(fd), "<fd>", /*replace=*/true);
 }
 
 void Manager::deleteAll()
 {
+    Metrics::Timer timer(metrics, Operation::deleteAll);
     // TODO: #Issue 4 when a certificate is deleted system auto generates
     // certificate file. At present we are not supporting creation of
     // certificate object for the auto-generated certificate file as
     // deletion if only applicable for REST server and Bmcweb does not allow
     // deletion of certificates
     installedCerts.clear();
+    reindexCertificates();
+    std::erase_if(installJobs,
+                  [](const auto& job) { return !job.second->isInProgress(); });
     // If the authorities list exists, delete it as well
     if (certType == CertificateType::authority)
     {
@@ -409,7 +778,9 @@ void Manager::deleteAll()
     }
     certIdCounter = 1;
     storageUpdate();
-    reloadOrReset(unitToRestart);
+    authoritiesListInSync = false;
+    saveStoreIndex();
+    requestReload();
 }
 
 void Manager::deleteCertificate(const Certificate* const certificate)
@@ -421,9 +792,13 @@ void Manager::deleteCertificate(const Certificate* const certificate)
                      });
     if (certIt != installedCerts.end())
     {
+        unindexCertificate(**certIt);
+        unlinkCertificate(**certIt);
+        installJobs.erase((*certIt)->getObjectPath());
         installedCerts.erase(certIt);
-        storageUpdate();
-        reloadOrReset(unitToRestart);
+        authoritiesListInSync = false;
+        saveStoreIndex();
+        requestReload();
     }
     else
     {
@@ -436,16 +811,60 @@ void Manager::deleteCertificate(const Certificate* const certificate)
 void Manager::replaceCertificate(Certificate* const certificate,
                                  const std::string& filePath)
 {
-    if (isCertificateUnique(filePath, certificate))
+    if (!isCertificateUnique(filePath, certificate))
     {
-        certificate->install(filePath, false);
-        storageUpdate();
-        reloadOrReset(unitToRestart);
+        elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
     }
-    else
+    reinstallCertificate(*certificate,
+                         [&]() { certificate->install(filePath, false); });
+}
+
+void Manager::replaceCertificateFd(const std::string& certObjectPath, int fd)
+{
+    auto certIt = std::find_if(
+        installedCerts.begin(), installedCerts.end(),
+        [&certObjectPath](const std::unique_ptr<Certificate>& cert) {
+            return cert->getObjectPath() == certObjectPath;
+        });
+    if (certIt == installedCerts.end())
+    {
+        elog<InvalidArgument>(
+            Argument::ARGUMENT_NAME("CERTIFICATE"),
+            Argument::ARGUMENT_VALUE(certObjectPath.c_str()));
+    }
+    Certificate* certificate = certIt->get();
+    std::string pem = readUpload(fd);
+    if (!isCertificateUnique(*parseCert(pem), certificate))
     {
         elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
     }
+    reinstallCertificate(*certificate, [&]() {
+        certificate->installContent(std::move(pem));
+    });
+}
+
+void Manager::reinstallCertificate(Certificate& certificate,
+                                   const std::function<void()>& install)
+{
+    // The identifiers change with the content; whatever the install
+    // outcome, index and link the certificate with the state it ends up in
+    unindexCertificate(certificate);
+    unlinkCertificate(certificate);
+    try
+    {
+        install();
+    }
+    catch (...)
+    {
+        indexCertificate(certificate);
+        linkCertificate(certificate);
+        throw;
+    }
+    indexCertificate(certificate);
+    linkCertificate(certificate);
+    authoritiesListInSync = false;
+    saveStoreIndex();
+    requestReload();
 }
 
 std::string Manager::generateCSR(
@@ -457,90 +876,80 @@ std::string Manager::generateCSR(
     std::string organization, std::string organizationalUnit, std::string state,
     std::string surname, std::string unstructuredName)
 {
-    // We support only one CSR.
-    csrPtr.reset(nullptr);
-    auto pid = fork();
-    if (pid == -1)
+    Metrics::Timer timer(metrics, Operation::generateCSR);
+    if (numCSRsInProgress >= maxNumCSRs)
     {
-        log<level::ERR>("Error occurred during forking process");
-        report<InternalFailure>();
-    }
-    else if (pid == 0)
-    {
-        try
-        {
-            generateCSRHelper(alternativeNames, challengePassword, city,
-                              commonName, contactPerson, country, email,
-                              givenName, initials, keyBitLength, keyCurveId,
-                              keyPairAlgorithm, keyUsage, organization,
-                              organizationalUnit, state, surname,
-                              unstructuredName);
-            exit(EXIT_SUCCESS);
-        }
-        catch (const InternalFailure& e)
-        {
-            // commit the error reported in child process and exit
-            // Callback method from SDEvent Loop looks for exit status
-            exit(EXIT_FAILURE);
-            commit<InternalFailure>();
-        }
-        catch (const InvalidArgument& e)
-        {
-            // commit the error reported in child process and exit
-            // Callback method from SDEvent Loop looks for exit status
-            exit(EXIT_FAILURE);
-            commit<InvalidArgument>();
-        }
+        log<level::ERR>("Too many CSRs in progress",
+                        entry("COUNT=%zu", numCSRsInProgress));
+        elog<NotAllowed>(NotAllowedReason("Too many CSRs in progress"));
     }
-    else
+
+    // The pre-generated key of the curve, if any, is taken on the event loop
+    // thread; the pool is refilled when idle for the next CSR
+    auto pooledKey =
+        std::make_shared<EVPPkeyPtr>(nullptr, ::EVP_PKEY_free);
+    if (keyPairAlgorithm == "EC" || keyPairAlgorithm.empty())
     {
-        using namespace sdeventplus::source;
-        Child::Callback callback = [this](Child& eventSource,
-                                          const siginfo_t* si) {
-            eventSource.set_enabled(Enabled::On);
-            if (si->si_status != 0)
-            {
-                this->createCSRObject(Status::failure);
-            }
-            else
-            {
-                this->createCSRObject(Status::success);
-            }
-        };
-        try
+        if (int curveNid = getECCurveNid(keyCurveId); curveNid != NID_undef)
         {
-            sigset_t ss;
-            if (sigemptyset(&ss) < 0)
-            {
-                log<level::ERR>("Unable to initialize signal set");
-                elog<InternalFailure>();
-            }
-            if (sigaddset(&ss, SIGCHLD) < 0)
+            if (auto pooled = ecKeyPool.find(curveNid);
+                pooled != ecKeyPool.end())
             {
-                log<level::ERR>("Unable to add signal to signal set");
-                elog<InternalFailure>();
+                *pooledKey = std::move(pooled->second);
+                ecKeyPool.erase(pooled);
             }
+            ecKeyPoolCurves.insert(curveNid);
+            scheduleIdleWork();
+        }
+    }
 
-            // Block SIGCHLD first, so that the event loop can handle it
-            if (sigprocmask(SIG_BLOCK, &ss, nullptr) < 0)
-            {
-                log<level::ERR>("Unable to block signal");
-                elog<InternalFailure>();
-            }
-            if (childPtr)
+    if (!csrWorker)
+    {
+        csrWorker = std::make_unique<WorkerPool>(event, 1);
+    }
+    uint64_t csrId = csrIdCounter++;
+    ++numCSRsInProgress;
+    auto pem = std::make_shared<std::string>();
+    csrWorker->submit(
+        [this, csrId, pooledKey, pem, alternativeNames, challengePassword, city,
+         commonName, contactPerson, country, email, givenName, initials,
+         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage, organization,
+         organizationalUnit, state, surname, unstructuredName]() {
+            Metrics::Timer timer(metrics, Operation::csrGeneration);
+            *pem = generateCSRHelper(
+                csrId, std::move(*pooledKey), alternativeNames,
+                challengePassword, city, commonName, contactPerson, country,
+                email, givenName, initials, keyBitLength, keyCurveId,
+                keyPairAlgorithm, keyUsage, organization, organizationalUnit,
+                state, surname, unstructuredName);
+        },
+        [this, csrId, pem](std::exception_ptr error) {
+            --numCSRsInProgress;
+            Status status = Status::success;
+            if (error)
             {
-                childPtr.reset();
+                status = Status::failure;
+                try
+                {
+                    std::rethrow_exception(error);
+                }
+                catch (const InternalFailure& e)
+                {
+                    commit<InternalFailure>();
+                }
+                catch (const InvalidArgument& e)
+                {
+                    commit<InvalidArgument>();
+                }
+                catch (const std::exception& e)
+                {
+                    log<level::ERR>("CSR generation failed",
+                                    entry("ERR=%s", e.what()));
+                }
             }
-            childPtr = std::make_unique<Child>(event, pid, WEXITED | WSTOPPED,
-                                               std::move(callback));
-        }
-        catch (const InternalFailure& e)
-        {
-            commit<InternalFailure>();
-        }
-    }
-    auto csrObjectPath = objectPath + '/' + "csr";
-    return csrObjectPath;
+            createCSRObject(csrId, status, std::move(*pem));
+        });
+    return getCSRObjectPath(csrId);
 }
 
 std::vector<std::unique_ptr<Certificate>>& Manager::getCertificates()
@@ -548,7 +957,30 @@ std::vector<std::unique_ptr<Certificate>>& Manager::getCertificates()
     return installedCerts;
 }
 
-void Manager::generateCSRHelper(
+const Metrics& Manager::getMetrics() const
+{
+    return metrics;
+}
+
+const TrustSnapshot* Manager::getTrustSnapshot() const
+{
+    return trustSnapshot.get();
+}
+
+const InstallJob*
+    Manager::getInstallJob(const std::string& certObjectPath) const
+{
+    auto job = installJobs.find(certObjectPath);
+    return job != installJobs.end() ? job->second.get() : nullptr;
+}
+
+bool Manager::isInstallAsync() const
+{
+    return asyncInstall;
+}
+
+std::string Manager::generateCSRHelper(
+    uint64_t csrId, EVPPkeyPtr pooledKey,
     std::vector<std::string> alternativeNames, std::string challengePassword,
     std::string city, std::string commonName, std::string contactPerson,
     std::string country, std::string email, std::string givenName,
@@ -602,7 +1034,8 @@ void Manager::generateCSRHelper(
     if (keyPairAlgorithm == "RSA")
         pKey = getRSAKeyPair(keyBitLength);
     else if ((keyPairAlgorithm == "EC") || (keyPairAlgorithm.empty()))
-        pKey = generateECKeyPair(keyCurveId);
+        pKey = pooledKey ? std::move(pooledKey)
+                         : generateECKeyPair(keyCurveId);
     else
     {
         log<level::ERR>("Given Key pair algorithm is not supported. Supporting "
@@ -647,7 +1080,23 @@ void Manager::generateCSRHelper(
         elog<InternalFailure>();
     }
 
-    // Write private key to file
+    // Keep the key of each CSR for the certificate signed for it; the
+    // default file has the key of the latest CSR
+    fs::path csrDirectory = getCSRDirectory(csrId);
+    try
+    {
+        fs::create_directories(csrDirectory);
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        log<level::ERR>("Failed to create CSR directory",
+                        entry("ERR=%s", e.what()),
+                        entry("DIRECTORY=%s", csrDirectory.c_str()));
+        elog<InternalFailure>();
+    }
+    fs::path csrKeyFileName = fs::path(defaultCSRDirName) /
+                              std::to_string(csrId) / defaultPrivateKeyFileName;
+    writePrivateKey(pKey, csrKeyFileName.string());
     writePrivateKey(pKey, defaultPrivateKeyFileName);
 
     // set sign key of x509 req
@@ -659,8 +1108,19 @@ void Manager::generateCSRHelper(
     }
 
     log<level::INFO>("Writing CSR to file");
-    fs::path csrFilePath = certParentInstallPath / defaultCSRFileName;
-    writeCSR(csrFilePath.string(), x509Req);
+    writeCSR((csrDirectory / defaultCSRFileName).string(), x509Req);
+    writeCSR((certParentInstallPath / defaultCSRFileName).string(), x509Req);
+
+    // The CSR object serves the request from memory
+    BIOMemPtr bio(BIO_new(BIO_s_mem()), ::BIO_free);
+    if (!bio || PEM_write_bio_X509_REQ(bio.get(), x509Req.get()) <= 0)
+    {
+        log<level::ERR>("Error occurred while calling PEM_write_bio_X509_REQ");
+        elog<InternalFailure>();
+    }
+    BUF_MEM* mem = nullptr;
+    BIO_get_mem_ptr(bio.get(), &mem);
+    return std::string(mem->data, mem->length);
 }
 
 bool Manager::isExtendedKeyUsage(const std::string& usage)
@@ -854,6 +1314,34 @@ EVPPkeyPtr Manager::generateECKeyPair(const std::string& curveId)
 #endif
 }
 
+int Manager::getECCurveNid(const std::string& curveId)
+{
+    return OBJ_txt2nid(curveId.empty() ? defaultKeyCurveID : curveId.c_str());
+}
+
+bool Manager::refillECKeyPool()
+{
+    for (int curveNid : ecKeyPoolCurves)
+    {
+        if (ecKeyPool.contains(curveNid))
+        {
+            continue;
+        }
+        try
+        {
+            ecKeyPool.emplace(curveNid,
+                              generateECKeyPair(OBJ_nid2sn(curveNid)));
+        }
+        catch (const InternalFailure& e)
+        {
+            // CSRs with this curve generate their key themselves
+            ecKeyPoolCurves.erase(curveNid);
+        }
+        return true;
+    }
+    return false;
+}
+
 void Manager::writePrivateKey(const EVPPkeyPtr& pKey,
                               const std::string& privKeyFileName)
 {
@@ -895,20 +1383,37 @@ void Manager::addEntry(X509_NAME* x509Name, const char* field,
     }
 }
 
-void Manager::createCSRObject(const Status& status)
+void Manager::createCSRObject(uint64_t csrId, const Status& status,
+                              std::string&& pem)
 {
-    if (csrPtr)
-    {
-        csrPtr.reset(nullptr);
+    // Without the generated request, the CSR object reads it next to the
+    // install path it is given
+    fs::path csrInstallPath = getCSRDirectory(csrId) / defaultCSRFileName;
+    csrs.emplace(csrId, std::make_unique<CSR>(
+                            bus, getCSRObjectPath(csrId).c_str(),
+                            csrInstallPath.string(), status, std::move(pem)));
+    while (csrs.size() > maxNumCSRs)
+    {
+        auto oldest = csrs.begin();
+        std::error_code ec;
+        fs::remove_all(getCSRDirectory(oldest->first), ec);
+        csrs.erase(oldest);
     }
-    auto csrObjectPath = objectPath + '/' + "csr";
-    csrPtr = std::make_unique<CSR>(bus, csrObjectPath.c_str(),
-                                   certInstallPath.c_str(), status);
 }
 
-void Manager::writeCSR(const std::string& filePath, const X509ReqPtr& x509Req)
+std::string Manager::getCSRObjectPath(uint64_t csrId) const
 {
-    if (fs::exists(filePath))
+    return objectPath + "/csr/" + std::to_string(csrId);
+}
+
+fs::path Manager::getCSRDirectory(uint64_t csrId) const
+{
+    return certParentInstallPath / defaultCSRDirName / std::to_string(csrId);
+}
+
+void Manager::writeCSR(const std::string& filePath, const X509ReqPtr& x509Req)
+{
+    if (fs::exists(filePath))
     {
         log<level::INFO>("Removing the existing file",
                          entry("FILENAME=%s", filePath.c_str()));
@@ -954,11 +1459,18 @@ void Manager::createCertificates()
             elog<InternalFailure>();
         }
 
+        const std::vector<StoreIndexEntry> storeIndex =
+            readStoreIndex(certInstallPath);
+
         // If the authorities list exists, recover from it and return
         if (fs::path authoritiesListFilePath =
                 fs::path(certInstallPath) / defaultAuthoritiesListFileName;
             fs::exists(authoritiesListFilePath))
         {
+            if (restoreAuthoritiesList(storeIndex))
+            {
+                return;
+            }
             // remove all other files and directories
             for (auto& path : fs::directory_iterator(certInstallPath))
             {
@@ -967,23 +1479,73 @@ void Manager::createCertificates()
                     fs::remove_all(path);
                 }
             }
-            installAll(authoritiesListFilePath);
+            // The list of the store is only ever replaced by a rename, so
+            // the mapping backs every PEM view until the install completes
+            ReadOnlyFileMapping listMapping(authoritiesListFilePath);
+            installAuthorities(listMapping.view(), authoritiesListFilePath,
+                               /*replace=*/false);
             return;
         }
 
+        // Files left unchanged since they were indexed are restored from
+        // the index; the others, and the certificates expired since unless
+        // allowed, are validated again
+        std::unordered_map<std::string, const StoreIndexEntry*> indexed;
+        bool indexOutdated = false;
+        for (const auto& indexEntry : storeIndex)
+        {
+            if (indexEntry.isCertificate())
+            {
+                indexed.emplace(indexEntry.fileName, &indexEntry);
+            }
+            else
+            {
+                indexOutdated = true;
+            }
+        }
+
         for (auto& path : fs::directory_iterator(certInstallPath))
         {
             try
             {
+                // The symbolic links are recreated for the restored
+                // certificates; writes cut short by a crash left nothing
+                // but a temporary file
+                if (isStoreIndexFile(path) || isTemporaryFile(path) ||
+                    fs::is_symlink(path))
+                {
+                    continue;
+                }
                 // Assume here any regular file located in certificate directory
                 // contains certificates body. Do not want to use soft links
                 // would add value.
                 if (fs::is_regular_file(path))
                 {
-                    installedCerts.emplace_back(std::make_unique<Certificate>(
-                        bus, certObjectPath + std::to_string(certIdCounter++),
-                        certType, certInstallPath, path.path(),
-                        certWatchPtr.get(), *this, /*restore=*/true));
+                    std::string instancePath =
+                        certObjectPath + std::to_string(certIdCounter++);
+                    auto indexEntry = indexed.find(path.path().filename());
+                    if (indexEntry != indexed.end() &&
+                        isRestorableFromIndex(certInstallPath,
+                                              *indexEntry->second))
+                    {
+                        installedCerts.emplace_back(
+                            std::make_unique<Certificate>(
+                                bus, instancePath, certType,
+                                certInstallPath, *indexEntry->second,
+                                certWatchPtr.get(), *this));
+                        indexed.erase(indexEntry);
+                    }
+                    else
+                    {
+                        indexOutdated = true;
+                        installedCerts.emplace_back(
+                            std::make_unique<Certificate>(
+                                bus, instancePath, certType,
+                                certInstallPath, path.path(),
+                                certWatchPtr.get(), *this, /*restore=*/true));
+                    }
+                    indexCertificate(*installedCerts.back());
+                    linkCertificate(*installedCerts.back());
                 }
             }
             catch (const InternalFailure& e)
@@ -996,6 +1558,11 @@ void Manager::createCertificates()
                     "Existing certificate file is corrupted"));
             }
         }
+
+        if (indexOutdated || !indexed.empty())
+        {
+            saveStoreIndex();
+        }
     }
     else if (fs::exists(certInstallPath))
     {
@@ -1003,7 +1570,8 @@ void Manager::createCertificates()
         {
             installedCerts.emplace_back(std::make_unique<Certificate>(
                 bus, certObjectPath + '1', certType, certInstallPath,
-                certInstallPath, certWatchPtr.get(), *this, /*restore=*/false));
+                certInstallPath, certWatchPtr.get(), *this, /*restore=*/true));
+            indexCertificate(*installedCerts.back());
         }
         catch (const InternalFailure& e)
         {
@@ -1048,6 +1616,15 @@ EVPPkeyPtr Manager::getRSAKeyPair(const int64_t keyBitLength)
             Argument::ARGUMENT_NAME("KEYBITLENGTH"),
             Argument::ARGUMENT_VALUE(std::to_string(keyBitLength).c_str()));
     }
+    // The file is rarely replaced; keep its key rather than decoding it for
+    // every CSR
+    std::lock_guard lock(rsaKeyMutex);
+    if (rsaKey)
+    {
+        EVP_PKEY_up_ref(rsaKey.get());
+        return EVPPkeyPtr(rsaKey.get(), ::EVP_PKEY_free);
+    }
+
     fs::path rsaPrivateKeyFileName =
         certParentInstallPath / defaultRSAPrivateKeyFileName;
 
@@ -1070,37 +1647,127 @@ EVPPkeyPtr Manager::getRSAKeyPair(const int64_t keyBitLength)
         log<level::ERR>("Error occurred during PEM_read_PrivateKey call");
         elog<InternalFailure>();
     }
+    EVP_PKEY_up_ref(privateKey.get());
+    rsaKey.reset(privateKey.get());
     return privateKey;
 }
 
 void Manager::storageUpdate()
 {
-    if (certType == CertificateType::authority)
+    if (certType != CertificateType::authority)
     {
-        // Remove symbolic links in the certificate directory
-        for (auto& certPath : fs::directory_iterator(certInstallPath))
+        return;
+    }
+
+    // Remove symbolic links in the certificate directory
+    certsBySubjectHash.clear();
+    for (auto& certPath : fs::directory_iterator(certInstallPath))
+    {
+        try
         {
-            try
+            if (fs::is_symlink(certPath))
             {
-                if (fs::is_symlink(certPath))
-                {
-                    fs::remove(certPath);
-                }
-            }
-            catch (const std::exception& e)
-            {
-                log<level::ERR>(
-                    "Failed to remove symlink for certificate",
-                    entry("ERR=%s", e.what()),
-                    entry("SYMLINK=%s", certPath.path().string().c_str()));
-                elog<InternalFailure>();
+                fs::remove(certPath);
             }
         }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>(
+                "Failed to remove symlink for certificate",
+                entry("ERR=%s", e.what()),
+                entry("SYMLINK=%s", certPath.path().string().c_str()));
+            elog<InternalFailure>();
+        }
     }
 
     for (const auto& cert : installedCerts)
     {
-        cert->storageUpdate();
+        linkCertificate(*cert);
+    }
+}
+
+void Manager::linkCertificate(Certificate& cert)
+{
+    if (certType != CertificateType::authority)
+    {
+        return;
+    }
+
+    const std::string& subjectNameHash = cert.getSubjectNameHash();
+    auto& linked = certsBySubjectHash[subjectNameHash];
+    const std::string certFilePath = cert.getCertFilePath();
+    const fs::path linkPath =
+        fs::path(certInstallPath) /
+        (subjectNameHash + "." + std::to_string(linked.size()));
+    try
+    {
+        fs::create_symlink(certFilePath, linkPath);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to create symlink for certificate",
+                        entry("ERR=%s", e.what()),
+                        entry("FILE=%s", certFilePath.c_str()),
+                        entry("SYMLINK=%s", linkPath.c_str()));
+        if (linked.empty())
+        {
+            certsBySubjectHash.erase(subjectNameHash);
+        }
+        elog<InternalFailure>();
+    }
+    linked.push_back(&cert);
+}
+
+void Manager::unlinkCertificate(const Certificate& cert)
+{
+    if (certType != CertificateType::authority)
+    {
+        return;
+    }
+
+    auto hashIt = certsBySubjectHash.find(cert.getSubjectNameHash());
+    if (hashIt == certsBySubjectHash.end())
+    {
+        return;
+    }
+    auto& linked = hashIt->second;
+    auto certIt = std::find(linked.begin(), linked.end(), &cert);
+    if (certIt == linked.end())
+    {
+        return;
+    }
+
+    auto linkPath = [this, &hashIt](size_t slot) {
+        return fs::path(certInstallPath) /
+               (hashIt->first + "." + std::to_string(slot));
+    };
+    const size_t slot = static_cast<size_t>(certIt - linked.begin());
+    const size_t lastSlot = linked.size() - 1;
+    try
+    {
+        if (slot == lastSlot)
+        {
+            fs::remove(linkPath(slot));
+        }
+        else
+        {
+            // Replaces the link of |cert| in a single step
+            fs::rename(linkPath(lastSlot), linkPath(slot));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to remove symlink for certificate",
+                        entry("ERR=%s", e.what()),
+                        entry("SYMLINK=%s", linkPath(slot).c_str()));
+        elog<InternalFailure>();
+    }
+
+    *certIt = linked.back();
+    linked.pop_back();
+    if (linked.empty())
+    {
+        certsBySubjectHash.erase(hashIt);
     }
 }
 
@@ -1119,7 +1786,34 @@ void Manager::reloadOrReset(const std::string& unit)
                 defaultSystemdService, defaultSystemdObjectPath,
                 defaultSystemdInterface, "ReloadOrRestartUnit");
             method.append(unit, "replace");
-            bus.call_noreply(method);
+            // Don't block the event loop until systemd queued the job; the
+            // duration is the one until it did. Each request keeps its slot
+            // until the reply, so the earlier ones still get theirs handled
+            uint64_t reloadId = reloadIdCounter++;
+            auto slot = bus.call_async(
+                method, [this, reloadId, unit, start = Metrics::Clock::now()](
+                            sdbusplus::message_t reply) {
+                    metrics.record(Operation::reloadOrReset,
+                                   Metrics::Clock::now() - start);
+                    if (reply.is_method_error())
+                    {
+                        log<level::ERR>("Failed to reload or restart service",
+                                        entry("UNIT=%s", unit.c_str()));
+                        reloadFailed = true;
+                    }
+                    // sd-bus holds the slot, and so this handler, until it
+                    // returns
+                    reloadSlots.erase(reloadId);
+                    if (reloadSlots.empty())
+                    {
+                        bool succeeded = !std::exchange(reloadFailed, false);
+                        for (auto& done : std::exchange(reloadWaiters, {}))
+                        {
+                            done(succeeded);
+                        }
+                    }
+                });
+            reloadSlots.emplace(reloadId, std::move(slot));
         }
         catch (const sdbusplus::exception_t& e)
         {
@@ -1131,20 +1825,339 @@ void Manager::reloadOrReset(const std::string& unit)
     }
 }
 
+void Manager::requestReload()
+{
+    if constexpr (reloadBatchWindowMs == 0)
+    {
+        reloadOrReset(unitToRestart);
+    }
+    else
+    {
+        reloadPending = true;
+        if (!reloadTimer)
+        {
+            reloadTimer = std::make_unique<
+                sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>>(
+                event, [this](auto&) {
+                    try
+                    {
+                        flushReload();
+                    }
+                    catch (const InternalFailure& e)
+                    {
+                        commit<InternalFailure>();
+                    }
+                });
+        }
+        // The window opens with the first change, so a steady stream of
+        // changes can't postpone the reload forever
+        if (!reloadTimer->isEnabled())
+        {
+            reloadTimer->restartOnce(
+                std::chrono::milliseconds(reloadBatchWindowMs));
+        }
+    }
+}
+
+void Manager::flushReload()
+{
+    if (!reloadPending)
+    {
+        return;
+    }
+    reloadPending = false;
+    if (reloadTimer)
+    {
+        reloadTimer->setEnabled(false);
+    }
+    reloadOrReset(unitToRestart);
+}
+
+void Manager::waitForReloads(std::function<void(bool succeeded)> done)
+{
+    if (reloadSlots.empty())
+    {
+        done(true);
+        return;
+    }
+    reloadWaiters.push_back(std::move(done));
+}
+
 bool Manager::isCertificateUnique(const std::string& filePath,
                                   const Certificate* const certToDrop)
 {
-    if (std::any_of(
-            installedCerts.begin(), installedCerts.end(),
-            [&filePath, certToDrop](std::unique_ptr<Certificate> const& cert) {
-                return cert.get() != certToDrop && cert->isSame(filePath);
-            }))
+    // Nothing to compare with; don't parse the candidate at all
+    if (installedCerts.empty() ||
+        (installedCerts.size() == 1 && installedCerts[0].get() == certToDrop))
+    {
+        return true;
+    }
+    internal::X509Ptr cert = loadCert(filePath);
+    return isCertificateUnique(*cert, certToDrop);
+}
+
+bool Manager::isCertificateUnique(X509& candidate,
+                                  const Certificate* const certToDrop)
+{
+    auto isOther = [certToDrop](const auto& entry) {
+        return entry.second != certToDrop;
+    };
+    // An identical certificate shares the fingerprint; an equivalent one,
+    // e.g. re-encoded, still shares the certificate ID
+    auto [fpBegin, fpEnd] =
+        certsByFingerprint.equal_range(generateFingerprint(candidate));
+    if (std::any_of(fpBegin, fpEnd, isOther))
     {
         return false;
     }
-    else
+    auto [idBegin, idEnd] = certsById.equal_range(generateCertId(candidate));
+    return std::none_of(idBegin, idEnd, isOther);
+}
+
+void Manager::indexCertificate(Certificate& cert)
+{
+    certsById.emplace(cert.getCertId(), &cert);
+    certsByFingerprint.emplace(cert.getFingerprint(), &cert);
+    expiryScheduler.schedule(cert.getObjectPath(), cert.getExpirationTime());
+}
+
+void Manager::unindexCertificate(const Certificate& cert)
+{
+    auto eraseFrom = [&cert](auto& index, const std::string& key) {
+        auto [begin, end] = index.equal_range(key);
+        for (auto it = begin; it != end; ++it)
+        {
+            if (it->second == &cert)
+            {
+                index.erase(it);
+                return;
+            }
+        }
+    };
+    eraseFrom(certsById, cert.getCertId());
+    eraseFrom(certsByFingerprint, cert.getFingerprint());
+    expiryScheduler.unschedule(cert.getObjectPath());
+}
+
+bool Manager::restoreAuthoritiesList(
+    const std::vector<StoreIndexEntry>& storeIndex)
+{
+    // The index must list exactly the files of the store, all unchanged and
+    // none expired unless allowed
+    std::unordered_set<std::string> indexedFiles;
+    for (const auto& indexEntry : storeIndex)
     {
-        return true;
+        if (!isRestorableFromIndex(certInstallPath, indexEntry))
+        {
+            return false;
+        }
+        indexedFiles.insert(indexEntry.fileName);
+    }
+    if (!indexedFiles.contains(defaultAuthoritiesListFileName))
+    {
+        return false;
+    }
+    for (auto& path : fs::directory_iterator(certInstallPath))
+    {
+        if (!isStoreIndexFile(path) &&
+            !indexedFiles.contains(path.path().filename()))
+        {
+            return false;
+        }
+    }
+
+    for (const auto& indexEntry : storeIndex)
+    {
+        if (!indexEntry.isCertificate())
+        {
+            continue;
+        }
+        installedCerts.emplace_back(std::make_unique<Certificate>(
+            bus, objectPath + '/' + std::to_string(certIdCounter++), certType,
+            certInstallPath, indexEntry, certWatchPtr.get(), *this));
+        indexCertificate(*installedCerts.back());
+        linkCertificate(*installedCerts.back());
+    }
+    authoritiesListInSync = true;
+    log<level::INFO>("Restored authorities list from the store index",
+                     entry("NUM=%zu", installedCerts.size()));
+    return true;
+}
+
+void Manager::saveStoreIndex()
+{
+    if (certType != CertificateType::authority)
+    {
+        return;
+    }
+    updateTrustSnapshot();
+    shareAuthorities();
+
+    // The index holds every certificate; a batch of changes rewrites it
+    // once, and with lazy properties reading them now would build them all
+    storeIndexOutdated = true;
+    scheduleIdleWork();
+}
+
+void Manager::updateStoreIndex()
+{
+    std::vector<StoreIndexEntry> entries;
+    if (authoritiesListInSync)
+    {
+        StoreIndexEntry authoritiesList;
+        authoritiesList.fileName = defaultAuthoritiesListFileName;
+        if (statStoreFile(certInstallPath, authoritiesList))
+        {
+            entries.emplace_back(std::move(authoritiesList));
+        }
+    }
+    for (const auto& cert : installedCerts)
+    {
+        StoreIndexEntry indexEntry;
+        indexEntry.fileName = fs::path(cert->getCertFilePath()).filename();
+        if (!statStoreFile(certInstallPath, indexEntry))
+        {
+            continue;
+        }
+        indexEntry.certId = cert->getCertId();
+        indexEntry.subjectNameHash = cert->getSubjectNameHash();
+        indexEntry.fingerprint = cert->getFingerprint();
+        indexEntry.subject = cert->subject();
+        indexEntry.issuer = cert->issuer();
+        indexEntry.validNotBefore = cert->validNotBefore();
+        indexEntry.validNotAfter = cert->validNotAfter();
+        indexEntry.keyUsage = cert->keyUsage();
+        indexEntry.certificateString = cert->certificateString();
+        entries.emplace_back(std::move(indexEntry));
+    }
+    writeStoreIndex(certInstallPath, entries);
+}
+
+void Manager::updateTrustSnapshot()
+{
+    if (!trustSnapshot)
+    {
+        return;
+    }
+    // The PEMs were kept at install or restore, so neither the store is
+    // read again nor the lazy properties built
+    std::map<std::string, std::string> certificates;
+    for (const auto& cert : installedCerts)
+    {
+        certificates.emplace(cert->getCertFilePath(), cert->getPem());
+    }
+    trustSnapshot->update(certificates);
+}
+
+void Manager::shareAuthorities()
+{
+    AuthorityStore& authorityStore = AuthorityStore::getInstance();
+    if (!authorityStore.isEnabled() || certType != CertificateType::authority)
+    {
+        return;
+    }
+
+    std::unordered_set<std::string> installed;
+    for (const auto& cert : installedCerts)
+    {
+        const std::string& fingerprint = cert->getFingerprint();
+        installed.insert(fingerprint);
+        if (sharedAuthorities.contains(fingerprint))
+        {
+            continue;
+        }
+        try
+        {
+            // Only the certificates restored from the store index are read
+            // from their file; the others were parsed at install
+            if (X509* x509 = cert->getX509(); x509 != nullptr)
+            {
+                authorityStore.add(fingerprint, *x509);
+            }
+            else
+            {
+                internal::X509Ptr loaded = loadCert(cert->getCertFilePath());
+                authorityStore.add(fingerprint, *loaded);
+            }
+            sharedAuthorities.insert(fingerprint);
+        }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>("Failed to share authority certificate",
+                            entry("ERR=%s", e.what()),
+                            entry("FILE=%s", cert->getCertFilePath().c_str()));
+        }
+    }
+
+    std::vector<std::string> removed;
+    for (auto it = sharedAuthorities.begin(); it != sharedAuthorities.end();)
+    {
+        if (installed.contains(*it))
+        {
+            ++it;
+            continue;
+        }
+        removed.push_back(*it);
+        it = sharedAuthorities.erase(it);
+    }
+    authorityStore.remove(removed);
+}
+
+void Manager::scheduleIdleWork()
+{
+    if (!idleSource)
+    {
+        idleSource = std::make_unique<sdeventplus::source::Defer>(
+            event, [this](sdeventplus::source::EventBase&) { runIdleWork(); });
+        idleSource->set_priority(SD_EVENT_PRIORITY_IDLE);
+    }
+    idleSource->set_enabled(sdeventplus::source::Enabled::On);
+}
+
+void Manager::runIdleWork()
+{
+    // An exception escaping the callback would disable the source for good
+    try
+    {
+        // One certificate per iteration, so requests get served in between
+        for (const auto& cert : installedCerts)
+        {
+            if (cert->isAnnouncementPending())
+            {
+                cert->announce();
+                return;
+            }
+        }
+        if (storeIndexOutdated)
+        {
+            storeIndexOutdated = false;
+            updateStoreIndex();
+            return;
+        }
+        if (refillECKeyPool())
+        {
+            return;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to run the idle work",
+                        entry("ERR=%s", e.what()));
+        // Written again on the next iteration
+        storeIndexOutdated = true;
+        return;
+    }
+    idleSource->set_enabled(sdeventplus::source::Enabled::Off);
+}
+
+void Manager::reindexCertificates()
+{
+    certsById.clear();
+    certsByFingerprint.clear();
+    expiryScheduler.clear();
+    for (const auto& cert : installedCerts)
+    {
+        indexCertificate(*cert);
     }
 }
 
@@ -2,7 +2,15 @@
 
 #include "certificate.hpp"
 #include "csr.hpp"
+#include "expiry_scheduler.hpp"
+#include "fd_install.hpp"
+#include "install_job.hpp"
+#include "metrics.hpp"
+#include "reload_control.hpp"
+#include "store_index.hpp"
+#include "trust_snapshot.hpp"
 #include "watch.hpp"
+#include "worker_pool.hpp"
 
 #include <openssl/evp.h>
 #include <openssl/ossl_typ.h>
@@ -10,11 +18,20 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sdbusplus/server/object.hpp>
-#include <sdeventplus/source/child.hpp>
+#include <sdbusplus/slot.hpp>
+#include <sdeventplus/clock.hpp>
 #include <sdeventplus/source/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <xyz/openbmc_project/Certs/CSR/Create/server.hpp>
 #include <xyz/openbmc_project/Certs/Install/server.hpp>
@@ -53,7 +70,7 @@ class Manager : public internal::ManagerInterface
     Manager& operator=(const Manager&) = delete;
     Manager(Manager&&) = delete;
     Manager& operator=(Manager&&) = delete;
-    virtual ~Manager() = default;
+    virtual ~Manager();
 
     /** @brief Constructor to put object onto bus at a dbus path.
      *  @param[in] bus - Bus to attach to.
@@ -71,6 +88,10 @@ class Manager : public internal::ManagerInterface
      *  Replace the existing certificate key file with another
      *  (possibly CA signed) Certificate key file.
      *
+     *  With the async-install option the certificate is validated off the
+     *  event loop; the returned path carries an
+     *  xyz.openbmc_project.Common.Progress interface until then.
+     *
      *  @param[in] filePath - Certificate key file path.
      *
      *  @return Certificate object path.
@@ -88,6 +109,20 @@ class Manager : public internal::ManagerInterface
     std::vector<sdbusplus::message::object_path>
         installAll(std::string path) override;
 
+    /** @brief Install() with the certificate file passed as a descriptor
+     *  @param[in] fd - Descriptor of the certificate key file; it is read,
+     * not closed.
+     *  @return Certificate object path.
+     */
+    std::string installFd(int fd);
+
+    /** @brief InstallAll() with the list passed as a descriptor
+     *  @param[in] fd - Descriptor of the authorities list; it is read, not
+     * closed.
+     *  @return D-Bus object path to created objects.
+     */
+    std::vector<sdbusplus::message::object_path> installAllFd(int fd);
+
     /** @brief Implementation for ReplaceAll
      *  Replace the current authority lists and restart the associated services.
      *
@@ -98,6 +133,13 @@ class Manager : public internal::ManagerInterface
     std::vector<sdbusplus::message::object_path>
         replaceAll(std::string filePath) override;
 
+    /** @brief ReplaceAll() with the list passed as a descriptor
+     *  @param[in] fd - Descriptor of the authorities list; it is read, not
+     * closed.
+     *  @return D-Bus object path to created objects.
+     */
+    std::vector<sdbusplus::message::object_path> replaceAllFd(int fd);
+
     /** @brief Implementation for DeleteAll
      *  Delete all objects in the collection.
      */
@@ -112,6 +154,19 @@ class Manager : public internal::ManagerInterface
     void replaceCertificate(Certificate* const certificate,
                             const std::string& filePath);
 
+    /** @brief Replace the certificate with the file passed as a descriptor
+     *  @param[in] certObjectPath - Object path of the certificate.
+     *  @param[in] fd - Descriptor of the certificate file; it is read, not
+     * closed.
+     */
+    void replaceCertificateFd(const std::string& certObjectPath, int fd);
+
+    /** @brief Run the deferred work once the event loop is idle: announce
+     * the certificates whose properties are built lazily, write the store
+     * index, then pre-generate the EC keys of the next CSRs
+     */
+    void scheduleIdleWork();
+
     /** @brief Generate Private key and CSR file
      *  Generates the Private key file and CSR file based on the input
      *  parameters. Validation of the parameters is callers responsibility.
@@ -200,25 +255,69 @@ class Manager : public internal::ManagerInterface
      */
     std::vector<std::unique_ptr<Certificate>>& getCertificates();
 
+    /** @brief Get the durations of the operations of the manager */
+    const Metrics& getMetrics() const;
+
+    /** @brief Get the trust store snapshot; null unless the manager is of
+     * authority certificates */
+    const TrustSnapshot* getTrustSnapshot() const;
+
+    /** @brief Get the asynchronous install job at |certObjectPath|; null
+     * unless the install was queued and its job is still kept */
+    const InstallJob* getInstallJob(const std::string& certObjectPath) const;
+
     /** @brief Systemd unit reload or reset helper function
      *  Reload if the unit supports it and use a restart otherwise.
      *  @param[in] unit - service need to reload.
      */
     virtual void reloadOrReset(const std::string& unit);
 
-  private:
-    void generateCSRHelper(std::vector<std::string> alternativeNames,
-                           std::string challengePassword, std::string city,
-                           std::string commonName, std::string contactPerson,
-                           std::string country, std::string email,
-                           std::string givenName, std::string initials,
-                           int64_t keyBitLength, std::string keyCurveId,
-                           std::string keyPairAlgorithm,
-                           std::vector<std::string> keyUsage,
-                           std::string organization,
-                           std::string organizationalUnit, std::string state,
-                           std::string surname, std::string unstructuredName);
+    /** @brief Reload the unit consuming the certificates now if a change
+     *  waits for the batching window; for callers needing the reload to be
+     *  requested before they return
+     *
+     *  The destructor doesn't reload the unit: the owner of a manager flushes
+     *  it first, while the reloadOrReset of derived classes can still run.
+     */
+    void flushReload();
+
+    /** @brief Call |done| once systemd answered the reloads requested so far
+     *  @param[in] done - Called with whether all of them succeeded; right
+     *  away if none waits for its reply.
+     */
+    void waitForReloads(std::function<void(bool succeeded)> done);
+
+  protected:
+    /** @brief Whether installs validate the certificate on the worker pool
+     * and publish an install job meanwhile; the async-install option
+     */
+    virtual bool isInstallAsync() const;
+
+    /** @brief Rebuild the lookup indexes and the expiry schedule from the
+     * internal list
+     */
+    void reindexCertificates();
+
+    /** @brief Generate the key and request of a CSR; runs on the CSR worker
+     * thread, so it must not touch the state of the event loop thread
+     *  @param[in] csrId - ID of the CSR.
+     *  @param[in] pooledKey - Pre-generated EC key to use, if any.
+     *  The other parameters are the ones of generateCSR.
+     *  @return the request in PEM format
+     */
+    std::string generateCSRHelper(
+        uint64_t csrId,
+        std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)> pooledKey,
+        std::vector<std::string> alternativeNames,
+        std::string challengePassword, std::string city,
+        std::string commonName, std::string contactPerson,
+        std::string country, std::string email, std::string givenName,
+        std::string initials, int64_t keyBitLength, std::string keyCurveId,
+        std::string keyPairAlgorithm, std::vector<std::string> keyUsage,
+        std::string organization, std::string organizationalUnit,
+        std::string state, std::string surname, std::string unstructuredName);
 
+  private:
     /** @brief Generate RSA Key pair and get private key from key pair
      *  @param[in]  keyBitLength - KeyBit length.
      *  @return     Pointer to RSA private key
@@ -233,6 +332,17 @@ class Manager : public internal::ManagerInterface
     std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
         generateECKeyPair(const std::string& pKeyCurveId);
 
+    /** @brief Get the NID of a curve
+     *  @param[in]  curveId - Curve ID; empty for the default curve
+     *  @return     the curve NID, NID_undef if the curve is unknown
+     */
+    static int getECCurveNid(const std::string& curveId);
+
+    /** @brief Pre-generate the missing key of one pooled curve
+     *  @return     false if no key was missing
+     */
+    bool refillECKeyPool();
+
     /** @brief Write private key data to file
      *
      *  @param[in] pKey     - pointer to private key
@@ -256,10 +366,29 @@ class Manager : public internal::ManagerInterface
      */
     bool isExtendedKeyUsage(const std::string& usage);
 
-    /** @brief Create CSR D-Bus object by reading the data in the CSR file
-     *  @param[in] statis - SUCCESS/FAILURE In CSR generation.
+    /** @brief Create CSR D-Bus object serving the generated request
+     *  @param[in] csrId - ID of the CSR.
+     *  @param[in] status - SUCCESS/FAILURE In CSR generation.
+     *  @param[in] pem - The generated request in PEM format; empty if the
+     *                   CSR object is to read it from the CSR file.
+     */
+    void createCSRObject(uint64_t csrId, const Status& status,
+                         std::string&& pem);
+
+    /** @brief Have the unit consuming the certificates reloaded after a
+     *  change; changes within the batching window share a single reload
      */
-    void createCSRObject(const Status& status);
+    void requestReload();
+
+    /** @brief Get the D-Bus object path of a CSR
+     *  @param[in] csrId - ID of the CSR.
+     */
+    std::string getCSRObjectPath(uint64_t csrId) const;
+
+    /** @brief Get the directory keeping the key and request of a CSR
+     *  @param[in] csrId - ID of the CSR.
+     */
+    std::filesystem::path getCSRDirectory(uint64_t csrId) const;
 
     /** @brief Write generated CSR data to file
      *
@@ -281,7 +410,8 @@ class Manager : public internal::ManagerInterface
     void createRSAPrivateKeyFile();
 
     /** @brief Getting RSA private key
-     *  Getting RSA private key from generated file
+     *  Getting RSA private key from generated file; the file is only read
+     *  again once it changed, so it is safe to call from the CSR worker
      *  @param[in]  keyBitLength - Key bit length
      *  @return     Pointer to RSA key
      */
@@ -290,13 +420,30 @@ class Manager : public internal::ManagerInterface
 
     /** @brief Update certificate storage (remove outdated files, recreate
      * symbolic links, etc.).
+     *  Every symbolic link is rebuilt, so it is meant for startup and for
+     * changes of the whole store; single certificates use linkCertificate()
+     * and unlinkCertificate().
      */
     void storageUpdate();
 
+    /** @brief Create the hash.N symbolic link of an authority certificate
+     * in the first free slot of its subject name hash
+     *  @param[in] cert - Certificate from the internal list.
+     */
+    void linkCertificate(Certificate& cert);
+
+    /** @brief Remove the hash.N symbolic link of an authority certificate;
+     * the link in the last slot of the same hash is moved into the freed one
+     * so the slots stay consecutive. It shall be called while the
+     * certificate still holds the subject name hash it was linked with.
+     *  @param[in] cert - Certificate from the internal list.
+     */
+    void unlinkCertificate(const Certificate& cert);
+
     /** @brief Check if provided certificate is unique across all certificates
      * on the internal list.
      *  @param[in] certFilePath - Path to the file with certificate for
-     * uniqueness check.
+     * uniqueness check; the file is parsed only once.
      *  @param[in] certToDrop - Pointer to the certificate from the internal
      * list which should be not taken into account while uniqueness check.
      *  @return     Checking result. True if certificate is unique, false if
@@ -305,6 +452,110 @@ class Manager : public internal::ManagerInterface
     bool isCertificateUnique(const std::string& certFilePath,
                              const Certificate* const certToDrop = nullptr);
 
+    /** @brief Check if provided certificate is unique across all certificates
+     * on the internal list.
+     *  @param[in] cert - Already parsed certificate for uniqueness check.
+     *  @param[in] certToDrop - Pointer to the certificate from the internal
+     * list which should be not taken into account while uniqueness check.
+     *  @return     Checking result. True if certificate is unique, false if
+     * not.
+     */
+    bool isCertificateUnique(X509& cert,
+                             const Certificate* const certToDrop = nullptr);
+
+    /** @brief Throw NotAllowed if no more certificate may be installed */
+    void checkInstallAllowed() const;
+
+    /** @brief Validate the certificate on the worker pool and install it
+     * once validated
+     *  @param[in] pem - Content of the certificate key file.
+     *  @return Certificate object path.
+     */
+    std::string installAsync(std::string pem);
+
+    /** @brief Re-index and re-link the certificate around its install,
+     * then save and reload
+     *  @param[in] certificate - The certificate to replace.
+     *  @param[in] install - Installs the new content into |certificate|.
+     */
+    void reinstallCertificate(Certificate& certificate,
+                              const std::function<void()>& install);
+
+    /** @brief Throw NotAllowed if an authorities list may not be installed
+     *  @param[in] replace - Whether the list replaces the installed
+     * certificates.
+     */
+    void checkAuthoritiesListAllowed(bool replace) const;
+
+    /** @brief Install the authorities list file of a client; InstallAll and
+     * ReplaceAll share it, each tracking its own duration. The file is read
+     * into memory first, so the client may change it meanwhile.
+     *  @param[in] filePath - Path of the authorities list.
+     *  @param[in] replace - Whether the list replaces the installed
+     * certificates; they are kept if the list fails to install.
+     *  @return D-Bus object path to created objects.
+     */
+    std::vector<sdbusplus::message::object_path>
+        installAuthoritiesList(const std::string& filePath, bool replace);
+
+    /** @brief Install the authorities list from its content
+     *  @param[in] content - The authorities list.
+     *  @param[in] source - Where the content comes from, for the logs.
+     *  @param[in] replace - Whether the list replaces the installed
+     * certificates; they are kept if the list fails to install.
+     *  @return D-Bus object path to created objects.
+     */
+    std::vector<sdbusplus::message::object_path>
+        installAuthorities(std::string_view content, const std::string& source,
+                           bool replace);
+
+    /** @brief Returns the validation worker pool; threads are started on
+     * first use */
+    WorkerPool& getWorkerPool();
+
+    /** @brief Number of asynchronous installs still in progress */
+    size_t numInstallsInProgress() const;
+
+    /** @brief Add the certificate to the lookup indexes
+     *  @param[in] cert - Certificate from the internal list.
+     */
+    void indexCertificate(Certificate& cert);
+
+    /** @brief Remove the certificate from the lookup indexes; it shall be
+     * called while the certificate still holds the identifiers it was indexed
+     * with.
+     *  @param[in] cert - Certificate from the internal list.
+     */
+    void unindexCertificate(const Certificate& cert);
+
+    /** @brief Persist the store index of the authority certificates, so the
+     * next start can restore them without validating them again; it is
+     * written once the event loop is idle, or by the destructor. The trust
+     * store snapshot is updated right away.
+     */
+    void saveStoreIndex();
+
+    /** @brief Update the trust store snapshot from the installed
+     * certificates, if the manager has one */
+    void updateTrustSnapshot();
+
+    /** @brief Bring the authorities the manager shares with the process in
+     * line with the installed certificates, if the store is shared */
+    void shareAuthorities();
+
+    /** @brief Write the store index of the authority certificates now */
+    void updateStoreIndex();
+
+    /** @brief Run one step of the deferred work */
+    void runIdleWork();
+
+    /** @brief Restore the authorities list install from the store index
+     *  @param[in] storeIndex - Entries of the store index.
+     *  @return false if the index doesn't describe the store as it is, in
+     * which case nothing is restored
+     */
+    bool restoreAuthoritiesList(const std::vector<StoreIndexEntry>& storeIndex);
+
     /** @brief sdbusplus handler */
     sdbusplus::bus_t& bus;
 
@@ -326,19 +577,118 @@ class Manager : public internal::ManagerInterface
     /** @brief Collection of pointers to certificate */
     std::vector<std::unique_ptr<Certificate>> installedCerts;
 
-    /** @brief pointer to CSR */
-    std::unique_ptr<CSR> csrPtr = nullptr;
+    /** @brief Index of |installedCerts| by certificate ID */
+    std::unordered_multimap<std::string, Certificate*> certsById;
 
-    /** @brief SDEventPlus child pointer added to event loop */
-    std::unique_ptr<sdeventplus::source::Child> childPtr = nullptr;
+    /** @brief Index of |installedCerts| by SHA-256 fingerprint */
+    std::unordered_multimap<std::string, Certificate*> certsByFingerprint;
+
+    /** @brief Linked authority certificates by subject name hash; the
+     * position in the list is the N of the hash.N symbolic link */
+    std::unordered_map<std::string, std::vector<Certificate*>>
+        certsBySubjectHash;
+
+    /** @brief CSR objects by CSR ID; only the latest maxNumCSRs are kept */
+    std::map<uint64_t, std::unique_ptr<CSR>> csrs;
+
+    /** @brief CSR ID pool */
+    uint64_t csrIdCounter = 1;
+
+    /** @brief CSRs queued or generated by the CSR worker */
+    size_t numCSRsInProgress = 0;
+
+    /** @brief Idle priority source running the deferred work */
+    std::unique_ptr<sdeventplus::source::Defer> idleSource = nullptr;
+
+    /** @brief Timer closing the reload batching window */
+    std::unique_ptr<
+        sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>>
+        reloadTimer = nullptr;
+
+    /** @brief Whether a change waits for the unit to be reloaded */
+    bool reloadPending = false;
+
+    /** @brief Reply slots of the reload requests systemd didn't answer, by
+     * request ID; dropping a slot would drop the handler of its reply */
+    std::map<uint64_t, sdbusplus::slot_t> reloadSlots;
+
+    /** @brief Reload request ID pool */
+    uint64_t reloadIdCounter = 0;
+
+    /** @brief Whether a reload failed since |reloadSlots| was last empty */
+    bool reloadFailed = false;
+
+    /** @brief Callbacks of waitForReloads waiting for |reloadSlots| to be
+     * empty */
+    std::vector<std::function<void(bool)>> reloadWaiters;
+
+    /** @brief Whether the store index waits for the deferred work */
+    bool storeIndexOutdated = false;
+
+    /** @brief Single file bundle of the authority certificates */
+    std::unique_ptr<TrustSnapshot> trustSnapshot = nullptr;
+
+    /** @brief Fingerprints of the certificates the manager added to the
+     * shared authority store */
+    std::unordered_set<std::string> sharedAuthorities;
+
+    /** @brief Curves a key is pre-generated for: the default one and the
+     * ones CSRs were requested with */
+    std::set<int> ecKeyPoolCurves;
+
+    /** @brief Pre-generated EC keys by curve NID; each is handed to a single
+     * CSR and generated again when the event loop is idle */
+    std::map<int, std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>>
+        ecKeyPool;
 
     /** @brief Watch on self signed certificates */
     std::unique_ptr<Watch> certWatchPtr = nullptr;
 
+    /** @brief Watch on the RSA private key file, dropping |rsaKey| whenever
+     * the file changes */
+    std::unique_ptr<Watch> rsaKeyWatchPtr = nullptr;
+
+    /** @brief Guards |rsaKey|, which the CSR worker reads */
+    std::mutex rsaKeyMutex;
+
+    /** @brief The key of the RSA private key file, once read */
+    std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)> rsaKey{
+        nullptr, ::EVP_PKEY_free};
+
+    /** @brief Durations of the operations, served on D-Bus; declared
+     * before the workers, which record into it */
+    Metrics metrics;
+
+    /** @brief Signals the installed certificates as they expire */
+    ExpiryScheduler expiryScheduler;
+
+    /** @brief Installs certificates passed as file descriptors */
+    FdInstall fdInstall;
+
+    /** @brief Flushes the batched reloads on request */
+    ReloadControl reloadControl;
+
     /** @brief Parent path i.e certificate directory path */
     std::filesystem::path certParentInstallPath;
 
     /** @brief Certificate ID pool */
     uint64_t certIdCounter = 1;
+
+    /** @brief Whether the installed certificates are exactly the ones of the
+     * authorities list file; only then may a restart restore them from the
+     * store index instead of installing the list again */
+    bool authoritiesListInSync = false;
+
+    /** @brief Asynchronous installs by certificate object path; finished
+     * ones are kept until the next install request */
+    std::map<std::string, std::unique_ptr<InstallJob>> installJobs;
+
+    /** @brief Threads validating certificates off the event loop; declared
+     * at the end so the workers are joined before anything else goes away */
+    std::unique_ptr<WorkerPool> workerPool = nullptr;
+
+    /** @brief Thread generating the keys and requests of CSRs; only one, so
+     * the default key and request files are written one CSR at a time */
+    std::unique_ptr<WorkerPool> csrWorker = nullptr;
 };
 } // namespace phosphor::certs
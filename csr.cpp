@@ -32,10 +32,11 @@ using X509ReqPtr = std::unique_ptr<X509_REQ, decltype(&::X509_REQ_free)>;
 using BIOPtr = std::unique_ptr<BIO, decltype(&::BIO_free_all)>;
 
 CSR::CSR(sdbusplus::bus_t& bus, const char* path, std::string&& installPath,
-         const Status& status) :
+         const Status& status, std::string&& pem) :
     internal::CSRInterface(bus, path,
                            internal::CSRInterface::action::defer_emit),
-    objectPath(path), certInstallPath(std::move(installPath)), csrStatus(status)
+    objectPath(path), certInstallPath(std::move(installPath)),
+    csrStatus(status), csrPEM(std::move(pem))
 {
     // Emit deferred signal.
     this->emit_object_added();
@@ -48,6 +49,10 @@ std::string CSR::csr()
         log<level::ERR>("Failure in Generating CSR");
         elog<InternalFailure>();
     }
+    if (!csrPEM.empty())
+    {
+        return csrPEM;
+    }
     fs::path csrFilePath = certInstallPath;
     csrFilePath = csrFilePath.parent_path() / defaultCSRFileName;
     if (!fs::exists(csrFilePath))
@@ -36,9 +36,11 @@ class CSR : public internal::CSRInterface
      *  @param[in] path - The D-Bus object path to attach at.
      *  @param[in] installPath - Certificate installation path.
      *  @param[in] status - Status of Generate CSR request
+     *  @param[in] pem - The generated CSR in PEM format; if empty, the CSR
+     *                   is read from the CSR file next to the install path
      */
     CSR(sdbusplus::bus_t& bus, const char* path, std::string&& installPath,
-        const Status& status);
+        const Status& status, std::string&& pem = std::string());
     /** @brief Return CSR
      */
     std::string csr() override;
@@ -52,5 +54,8 @@ class CSR : public internal::CSRInterface
 
     /** @brief Status of GenerateCSR request */
     Status csrStatus;
+
+    /** @brief The generated CSR in PEM format, if known */
+    std::string csrPEM;
 };
 } // namespace phosphor::certs
@@ -0,0 +1,227 @@
+#include "config.h"
+
+#include "expiry_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+constexpr uint64_t warningSeconds = expiryWarningDays * 24 * 60 * 60;
+
+// Longest delay the timer is armed for, in seconds
+constexpr uint64_t maxTimerDelay = 24 * 60 * 60;
+} // namespace
+
+const sdbusplus::vtable_t ExpiryScheduler::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::signal("ExpiringSoon", "ot"),
+    sdbusplus::vtable::signal("Expired", "ot"),
+    sdbusplus::vtable::method("GetExpiringCertificates", "", "a(otb)",
+                              ExpiryScheduler::callGetExpiringCertificates),
+    sdbusplus::vtable::end()};
+
+ExpiryScheduler::ExpiryScheduler(sdbusplus::bus_t& bus,
+                                 sdeventplus::Event& event, const char* path) :
+    timer(event, [this](Timer&) { run(); }),
+    expiryInterface(bus, path, expiryInterfaceName, vtable, this)
+{}
+
+void ExpiryScheduler::schedule(const std::string& objectPath,
+                               uint64_t validNotAfter)
+{
+    // The deadlines pushed for the path before, even with the same
+    // expiration time, are stale from now on
+    uint64_t sequence = nextSequence++;
+    tracked[objectPath] = Tracked{validNotAfter, sequence};
+    // Only the thresholds not signaled for this expiration time are left
+    Signaled done{validNotAfter, false, false};
+    if (auto found = signaled.find(objectPath);
+        found != signaled.end() && found->second.validNotAfter == validNotAfter)
+    {
+        done = found->second;
+    }
+    // A certificate expired already only gets the Expired signal
+    if (!done.expiringSoon && validNotAfter > getCurrentTime())
+    {
+        uint64_t warningTime =
+            validNotAfter > warningSeconds ? validNotAfter - warningSeconds : 0;
+        deadlines.push(
+            Deadline{warningTime, false, objectPath, validNotAfter, sequence});
+    }
+    if (!done.expired)
+    {
+        deadlines.push(
+            Deadline{validNotAfter, true, objectPath, validNotAfter, sequence});
+    }
+    compact();
+    arm();
+}
+
+void ExpiryScheduler::unschedule(const std::string& objectPath)
+{
+    // Its deadlines are dropped once they pass
+    tracked.erase(objectPath);
+    compact();
+}
+
+void ExpiryScheduler::clear()
+{
+    tracked.clear();
+    deadlines = {};
+    timer.setEnabled(false);
+}
+
+std::vector<ExpiryScheduler::ExpiringCertificate>
+    ExpiryScheduler::getExpiringCertificates() const
+{
+    uint64_t now = getCurrentTime();
+    std::vector<ExpiringCertificate> expiring;
+    for (const auto& [objectPath, certificate] : tracked)
+    {
+        uint64_t validNotAfter = certificate.validNotAfter;
+        if (validNotAfter <= now + warningSeconds)
+        {
+            expiring.emplace_back(objectPath, validNotAfter,
+                                  validNotAfter <= now);
+        }
+    }
+    std::sort(expiring.begin(), expiring.end(),
+              [](const auto& a, const auto& b) {
+                  return std::get<1>(a) < std::get<1>(b);
+              });
+    return expiring;
+}
+
+void ExpiryScheduler::notify(const std::string& objectPath,
+                             uint64_t validNotAfter, bool expired)
+{
+    log<level::NOTICE>(expired ? "Certificate expired"
+                               : "Certificate expiring soon",
+                       entry("OBJPATH=%s", objectPath.c_str()),
+                       entry("VALID_NOT_AFTER=%llu",
+                             static_cast<unsigned long long>(validNotAfter)));
+    auto signal = expiryInterface.new_signal(expired ? "Expired"
+                                                     : "ExpiringSoon");
+    signal.append(sdbusplus::message::object_path(objectPath), validNotAfter);
+    signal.signal_send();
+}
+
+void ExpiryScheduler::run()
+{
+    uint64_t now = getCurrentTime();
+    while (!deadlines.empty() && deadlines.top().time <= now)
+    {
+        Deadline deadline = deadlines.top();
+        deadlines.pop();
+        if (!isLive(deadline))
+        {
+            continue;
+        }
+        Signaled& done = signaled[deadline.objectPath];
+        if (done.validNotAfter != deadline.validNotAfter)
+        {
+            done = Signaled{deadline.validNotAfter, false, false};
+        }
+        (deadline.expired ? done.expired : done.expiringSoon) = true;
+        notify(deadline.objectPath, deadline.validNotAfter, deadline.expired);
+    }
+    // The timer never runs while the manager indexes its certificates
+    // again, so the certificates gone by now are gone for good
+    std::erase_if(signaled, [this](const auto& entry) {
+        return !tracked.contains(entry.first);
+    });
+    arm();
+}
+
+void ExpiryScheduler::arm()
+{
+    if (deadlines.empty())
+    {
+        timer.setEnabled(false);
+        return;
+    }
+    // Expiration times may be centuries away, past what the clock durations
+    // hold; a later deadline is served by waking up again once the delay
+    // passed
+    uint64_t now = getCurrentTime();
+    uint64_t time = deadlines.top().time;
+    uint64_t delay = time > now ? std::min(time - now, maxTimerDelay) : 0;
+    timer.restartOnce(std::chrono::seconds(delay));
+}
+
+bool ExpiryScheduler::isLive(const Deadline& deadline) const
+{
+    auto current = tracked.find(deadline.objectPath);
+    return current != tracked.end() &&
+           current->second.sequence == deadline.sequence;
+}
+
+uint64_t ExpiryScheduler::getCurrentTime() const
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+}
+
+void ExpiryScheduler::compact()
+{
+    // Each certificate has at most two live deadlines
+    if (deadlines.size() <= 4 * (tracked.size() + 1))
+    {
+        return;
+    }
+    std::vector<Deadline> live;
+    live.reserve(tracked.size() * 2);
+    for (; !deadlines.empty(); deadlines.pop())
+    {
+        const Deadline& deadline = deadlines.top();
+        if (isLive(deadline))
+        {
+            live.push_back(deadline);
+        }
+    }
+    deadlines = decltype(deadlines)(std::greater<>(), std::move(live));
+}
+
+int ExpiryScheduler::callGetExpiringCertificates(sd_bus_message* msg,
+                                                 void* context,
+                                                 sd_bus_error* error)
+{
+    auto scheduler = static_cast<ExpiryScheduler*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        auto reply = call.new_method_return();
+        reply.append(scheduler->getExpiringCertificates());
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        // Unwinding through the sd-bus callback would abort the daemon
+        log<level::ERR>("Failed to list the expiring certificates",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,183 @@
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message/native_types.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @brief Interface announcing the expiration of the certificates of a
+ *  manager
+ */
+inline constexpr char expiryInterfaceName[] =
+    "xyz.openbmc_project.Certs.Expiry";
+
+/** @class ExpiryScheduler
+ *
+ *  @brief Signals the certificates of a manager as they expire
+ *
+ *  The certificates are kept in a min-heap of their deadlines, backed by a
+ *  single real time clock timer armed for the earliest one. Each threshold
+ *  of a certificate is signaled once per expiration time, however often it
+ *  is scheduled again, e.g. when the manager indexes its certificates
+ *  again. The interface,
+ *  at the manager object path, has:
+ *  - signal ExpiringSoon(o path, t validNotAfter), once expiryWarningDays
+ *    remain until the certificate expires;
+ *  - signal Expired(o path, t validNotAfter), once it expired;
+ *  - method GetExpiringCertificates() -> a(otb): the certificates expiring
+ *    soon or expired, with their expiration time and whether they expired,
+ *    for the monitors starting to listen.
+ */
+class ExpiryScheduler
+{
+  public:
+    /** @brief A certificate expiring soon: its object path, expiration time
+     *  and whether it expired already
+     */
+    using ExpiringCertificate =
+        std::tuple<sdbusplus::message::object_path, uint64_t, bool>;
+
+    /** @brief ctor - put the expiry interface onto the bus
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] event - sd-event object the timer runs on.
+     *  @param[in] path - Path of the manager.
+     */
+    ExpiryScheduler(sdbusplus::bus_t& bus, sdeventplus::Event& event,
+                    const char* path);
+    ExpiryScheduler(const ExpiryScheduler&) = delete;
+    ExpiryScheduler& operator=(const ExpiryScheduler&) = delete;
+    ExpiryScheduler(ExpiryScheduler&&) = delete;
+    ExpiryScheduler& operator=(ExpiryScheduler&&) = delete;
+    virtual ~ExpiryScheduler() = default;
+
+    /** @brief Track the expiration of a certificate, replacing the one
+     *  tracked at the same path, if any
+     *  @param[in] objectPath - Object path of the certificate.
+     *  @param[in] validNotAfter - Expiration time, in seconds since epoch.
+     */
+    void schedule(const std::string& objectPath, uint64_t validNotAfter);
+
+    /** @brief Stop tracking the certificate
+     *  @param[in] objectPath - Object path of the certificate.
+     */
+    void unschedule(const std::string& objectPath);
+
+    /** @brief Stop tracking every certificate; the thresholds signaled
+     *  already aren't signaled again once they are scheduled again
+     */
+    void clear();
+
+    /** @brief Get the certificates expiring soon or expired */
+    std::vector<ExpiringCertificate> getExpiringCertificates() const;
+
+  protected:
+    /** @brief Emit the ExpiringSoon or Expired signal of the certificate
+     *  @param[in] objectPath - Object path of the certificate.
+     *  @param[in] validNotAfter - Expiration time, in seconds since epoch.
+     *  @param[in] expired - Whether the certificate expired.
+     */
+    virtual void notify(const std::string& objectPath, uint64_t validNotAfter,
+                        bool expired);
+
+    /** @brief Current time, in seconds since epoch */
+    virtual uint64_t getCurrentTime() const;
+
+    /** @brief Notify the deadlines which passed and arm the timer for the
+     *  next one
+     */
+    void run();
+
+  private:
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::RealTime>;
+
+    /** @brief A threshold of a certificate: expiring soon or expired */
+    struct Deadline
+    {
+        uint64_t time;
+        bool expired;
+        std::string objectPath;
+        uint64_t validNotAfter;
+        /** @brief The schedule() call which pushed the deadline */
+        uint64_t sequence;
+
+        auto operator<=>(const Deadline&) const = default;
+    };
+
+    /** @brief A tracked certificate: its expiration time and the last
+     *  schedule() call for it
+     */
+    struct Tracked
+    {
+        uint64_t validNotAfter;
+        uint64_t sequence;
+    };
+
+    /** @brief Thresholds of a certificate signaled for an expiration time
+     */
+    struct Signaled
+    {
+        uint64_t validNotAfter;
+        bool expiringSoon;
+        bool expired;
+    };
+
+    /** @brief Whether the deadline was pushed by the last schedule() call
+     *  of its certificate, which wasn't unscheduled since
+     */
+    bool isLive(const Deadline& deadline) const;
+
+    /** @brief Arm the timer for the earliest deadline */
+    void arm();
+
+    /** @brief Drop the deadlines which aren't live once these stale
+     *  deadlines outnumber the live ones
+     */
+    void compact();
+
+    /** @brief D-Bus handler of the expiry interface */
+    static int callGetExpiringCertificates(sd_bus_message* msg, void* context,
+                                           sd_bus_error* error);
+
+    /** @brief Members of the expiry interface */
+    static const sdbusplus::vtable_t vtable[];
+
+    /** @brief Tracked certificates, by object path; deadlines of former
+     *  schedule() calls are stale
+     */
+    std::unordered_map<std::string, Tracked> tracked;
+
+    /** @brief Signaled thresholds, by object path; kept while the
+     *  certificates are scheduled again, dropped once they are gone
+     */
+    std::unordered_map<std::string, Signaled> signaled;
+
+    /** @brief Sequence number of the next schedule() call */
+    uint64_t nextSequence = 0;
+
+    /** @brief Deadlines, earliest first */
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>>
+        deadlines;
+
+    /** @brief Timer armed for the earliest deadline */
+    Timer timer;
+
+    /** @brief The expiry interface */
+    sdbusplus::server::interface_t expiryInterface;
+};
+
+} // namespace phosphor::certs
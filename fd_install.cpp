@@ -0,0 +1,153 @@
+#include "fd_install.hpp"
+
+#include "certs_manager.hpp"
+
+#include <exception>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+#include <sdbusplus/message/native_types.hpp>
+#include <string>
+#include <vector>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+} // namespace
+
+const sdbusplus::vtable_t FdInstall::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method("Install", "h", "o", FdInstall::callInstall),
+    sdbusplus::vtable::method("InstallAll", "h", "ao",
+                              FdInstall::callInstallAll),
+    sdbusplus::vtable::method("ReplaceAll", "h", "ao",
+                              FdInstall::callReplaceAll),
+    sdbusplus::vtable::method("Replace", "oh", "", FdInstall::callReplace),
+    sdbusplus::vtable::end()};
+
+FdInstall::FdInstall(sdbusplus::bus_t& bus, const char* path,
+                     Manager& manager) :
+    manager(manager),
+    fdInstallInterface(bus, path, fdInstallInterfaceName, vtable, this)
+{}
+
+int FdInstall::callInstall(sd_bus_message* msg, void* context,
+                           sd_bus_error* error)
+{
+    auto fdInstall = static_cast<FdInstall*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        sdbusplus::message::unix_fd fd;
+        call.read(fd);
+        sdbusplus::message::object_path certObjectPath(
+            fdInstall->manager.installFd(fd.fd));
+        auto reply = call.new_method_return();
+        reply.append(certObjectPath);
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        // Unwinding through the sd-bus callback would abort the daemon
+        log<level::ERR>("Failed to handle the fd install call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+int FdInstall::callInstallAll(sd_bus_message* msg, void* context,
+                              sd_bus_error* error)
+{
+    auto fdInstall = static_cast<FdInstall*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        sdbusplus::message::unix_fd fd;
+        call.read(fd);
+        std::vector<sdbusplus::message::object_path> objects =
+            fdInstall->manager.installAllFd(fd.fd);
+        auto reply = call.new_method_return();
+        reply.append(objects);
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to handle the fd install call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+int FdInstall::callReplaceAll(sd_bus_message* msg, void* context,
+                              sd_bus_error* error)
+{
+    auto fdInstall = static_cast<FdInstall*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        sdbusplus::message::unix_fd fd;
+        call.read(fd);
+        std::vector<sdbusplus::message::object_path> objects =
+            fdInstall->manager.replaceAllFd(fd.fd);
+        auto reply = call.new_method_return();
+        reply.append(objects);
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to handle the fd install call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+int FdInstall::callReplace(sd_bus_message* msg, void* context,
+                           sd_bus_error* error)
+{
+    auto fdInstall = static_cast<FdInstall*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        sdbusplus::message::object_path certObjectPath;
+        sdbusplus::message::unix_fd fd;
+        call.read(certObjectPath, fd);
+        fdInstall->manager.replaceCertificateFd(certObjectPath, fd.fd);
+        auto reply = call.new_method_return();
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to handle the fd install call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+} // namespace phosphor::certs
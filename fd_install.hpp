@@ -0,0 +1,71 @@
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+
+namespace phosphor::certs
+{
+
+/** @brief Interface installing the certificates of a manager from file
+ *  descriptors
+ */
+inline constexpr char fdInstallInterfaceName[] =
+    "xyz.openbmc_project.Certs.FdInstall";
+
+class Manager; // Forward declaration for Certificate Manager.
+
+/** @class FdInstall
+ *
+ *  @brief Variants of Install, InstallAll, ReplaceAll and Replace taking the
+ *  certificate file as a descriptor of a regular file, e.g. a memfd
+ *
+ *  The manager reads the file once into memory, validates it there and
+ *  writes the installed file with a single atomic write; the client doesn't
+ *  need to stage the upload on a file system. The interface, at the manager
+ *  object path, has the methods:
+ *  - Install(h fd) -> o: the object path of the installed certificate;
+ *  - InstallAll(h fd) -> ao and ReplaceAll(h fd) -> ao: the object paths
+ *    of the installed authorities;
+ *  - Replace(o certificate, h fd): replace an installed certificate.
+ *  They fail with the errors of the path based methods, and with
+ *  InvalidArgument for descriptors of anything but a regular file: reading a
+ *  pipe or a socket could block the event loop until the sender closes it.
+ */
+class FdInstall
+{
+  public:
+    /** @brief ctor - put the interface onto the bus
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - Path of the manager.
+     *  @param[in] manager - The manager installing the certificates.
+     */
+    FdInstall(sdbusplus::bus_t& bus, const char* path, Manager& manager);
+    FdInstall(const FdInstall&) = delete;
+    FdInstall& operator=(const FdInstall&) = delete;
+    FdInstall(FdInstall&&) = delete;
+    FdInstall& operator=(FdInstall&&) = delete;
+    ~FdInstall() = default;
+
+  private:
+    /** @brief D-Bus handlers of the interface */
+    static int callInstall(sd_bus_message* msg, void* context,
+                           sd_bus_error* error);
+    static int callInstallAll(sd_bus_message* msg, void* context,
+                              sd_bus_error* error);
+    static int callReplaceAll(sd_bus_message* msg, void* context,
+                              sd_bus_error* error);
+    static int callReplace(sd_bus_message* msg, void* context,
+                           sd_bus_error* error);
+
+    /** @brief Methods of the interface */
+    static const sdbusplus::vtable_t vtable[];
+
+    Manager& manager;
+
+    /** @brief The fd install interface */
+    sdbusplus::server::interface_t fdInstallInterface;
+};
+
+} // namespace phosphor::certs
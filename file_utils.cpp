@@ -0,0 +1,286 @@
+#include "file_utils.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <stdexcept>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+namespace fs = std::filesystem;
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+// Prefix of the temporary files; a leading dot keeps them out of listings
+constexpr std::string_view tempFilePrefix = ".tmp.";
+// Random part of the unique names, as mkstemp() and mkdtemp() want it
+constexpr char uniqueNameSuffix[] = "XXXXXX";
+
+// umask() can only be read by setting it, which would race with the files
+// the worker threads create; read it once while the process starts
+const mode_t processUmask = []() {
+    mode_t mask = umask(0);
+    umask(mask);
+    return mask;
+}();
+
+// Closes the descriptor when the scope exits
+class FileDescriptor
+{
+  public:
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor()
+    {
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+    }
+
+    int get() const
+    {
+        return fd;
+    }
+
+    /** @brief Close the descriptor now, reporting errors of the last write */
+    int close()
+    {
+        int rc = ::close(fd);
+        fd = -1;
+        return rc;
+    }
+
+  private:
+    int fd;
+};
+
+bool writeAll(int fd, std::string_view content)
+{
+    while (!content.empty())
+    {
+        ssize_t written = ::write(fd, content.data(), content.size());
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        content.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+// Makes the rename itself durable
+void syncDirectory(const fs::path& directory)
+{
+    FileDescriptor dirFd(
+        open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dirFd.get() == -1 || fsync(dirFd.get()) == -1)
+    {
+        // The file itself is complete; only its name may not survive a crash
+        log<level::WARNING>("Failed to sync directory",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("DIR=%s", directory.c_str()));
+    }
+}
+} // namespace
+
+std::string readFile(const std::string& filePath)
+{
+    FileDescriptor fd(open(filePath.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st
+    {};
+    if (fd.get() == -1 || fstat(fd.get(), &st) == -1)
+    {
+        log<level::ERR>("Failed to open file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("FILE=%s", filePath.c_str()));
+        elog<InternalFailure>();
+    }
+
+    // The size is only a hint; the file may change while it is read
+    std::string content;
+    content.resize(static_cast<size_t>(st.st_size) + 1);
+    size_t size = 0;
+    while (true)
+    {
+        if (size == content.size())
+        {
+            content.resize(content.size() * 2);
+        }
+        ssize_t numRead =
+            ::read(fd.get(), content.data() + size, content.size() - size);
+        if (numRead == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numRead == -1)
+        {
+            log<level::ERR>("Failed to read file",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("FILE=%s", filePath.c_str()));
+            elog<InternalFailure>();
+        }
+        if (numRead == 0)
+        {
+            break;
+        }
+        size += static_cast<size_t>(numRead);
+    }
+    content.resize(size);
+    return content;
+}
+
+std::string readFd(int fd, size_t maxSize)
+{
+    // Reading a pipe or a socket could block until the sender closes it
+    struct stat st
+    {};
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+    {
+        log<level::ERR>("File descriptor is not of a regular file",
+                        entry("FD=%d", fd));
+        throw std::invalid_argument("Not a regular file");
+    }
+    // One byte more tells a file of the maximum size from a larger one
+    size_t limit = maxSize + 1;
+    // The sender may have left the offset of the memfd it wrote at the end
+    std::string content;
+    content.resize(std::min(static_cast<size_t>(st.st_size) + 1, limit));
+    size_t size = 0;
+    while (size < limit)
+    {
+        if (size == content.size())
+        {
+            content.resize(std::min(content.size() * 2, limit));
+        }
+        ssize_t numRead = ::pread(fd, content.data() + size,
+                                  content.size() - size,
+                                  static_cast<off_t>(size));
+        if (numRead == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numRead == -1)
+        {
+            log<level::ERR>("Failed to read file descriptor",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("FD=%d", fd));
+            elog<InternalFailure>();
+        }
+        if (numRead == 0)
+        {
+            break;
+        }
+        size += static_cast<size_t>(numRead);
+    }
+    if (size > maxSize)
+    {
+        log<level::ERR>("File is too large", entry("FD=%d", fd),
+                        entry("LIMIT=%zu", maxSize));
+        throw std::length_error("File is too large");
+    }
+    content.resize(size);
+    return content;
+}
+
+void writeFileAtomically(const std::string& filePath, std::string_view content)
+{
+    fs::path path(filePath);
+    fs::path directory = path.parent_path();
+    std::string tempPath = directory / (std::string(tempFilePrefix) +
+                                        path.filename().string() + '.' +
+                                        uniqueNameSuffix);
+
+    mode_t mode = 0666 & ~processUmask;
+    struct stat st
+    {};
+    if (stat(filePath.c_str(), &st) == 0)
+    {
+        mode = st.st_mode & 07777;
+    }
+
+    FileDescriptor fd(mkostemp(tempPath.data(), O_CLOEXEC));
+    if (fd.get() == -1)
+    {
+        log<level::ERR>("Failed to create temporary file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("DST=%s", filePath.c_str()));
+        elog<InternalFailure>();
+    }
+    if (fchmod(fd.get(), mode) == -1 || !writeAll(fd.get(), content) ||
+        fsync(fd.get()) == -1 || fd.close() == -1 ||
+        rename(tempPath.c_str(), filePath.c_str()) == -1)
+    {
+        int error = errno;
+        unlink(tempPath.c_str());
+        log<level::ERR>("Failed to write file",
+                        entry("ERR=%s", std::strerror(error)),
+                        entry("DST=%s", filePath.c_str()));
+        elog<InternalFailure>();
+    }
+    syncDirectory(directory.empty() ? fs::path(".") : directory);
+}
+
+std::string createUniqueFile(const std::string& directoryPath)
+{
+    std::string filePath =
+        fs::path(directoryPath) / (std::string("file") + uniqueNameSuffix);
+    FileDescriptor fd(mkostemp(filePath.data(), O_CLOEXEC));
+    if (fd.get() == -1)
+    {
+        log<level::ERR>("Failed to create file of unique name",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("DIR=%s", directoryPath.c_str()));
+        elog<InternalFailure>();
+    }
+    // mkstemp() creates the file private to the owner
+    if (fchmod(fd.get(), 0666 & ~processUmask) == -1)
+    {
+        log<level::WARNING>("Failed to set file permissions",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("FILE=%s", filePath.c_str()));
+    }
+    return filePath;
+}
+
+std::string createUniqueDirectory(const std::string& directoryPath)
+{
+    std::string path =
+        fs::path(directoryPath) / (std::string(tempFilePrefix) + "dir." +
+                                   uniqueNameSuffix);
+    if (mkdtemp(path.data()) == nullptr)
+    {
+        log<level::ERR>("Failed to create directory of unique name",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("DIR=%s", directoryPath.c_str()));
+        elog<InternalFailure>();
+    }
+    return path;
+}
+
+bool isTemporaryFile(const fs::path& path)
+{
+    return path.filename().string().starts_with(tempFilePrefix);
+}
+
+} // namespace phosphor::certs
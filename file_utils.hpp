@@ -0,0 +1,56 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace phosphor::certs
+{
+
+/** @brief Read the whole file at once
+ *  @param[in] filePath - Path of the file to read.
+ *  @return the file content
+ */
+std::string readFile(const std::string& filePath);
+
+/** @brief Read the regular file a descriptor passed by a client refers to,
+ *  e.g. a memfd, from its start and without moving its offset; other kinds
+ *  of descriptors, which could block the reader, raise
+ *  std::invalid_argument and files larger than |maxSize| std::length_error
+ *  @param[in] fd - The descriptor; it stays open.
+ *  @param[in] maxSize - The size of the largest file accepted.
+ *  @return the content
+ */
+std::string readFd(int fd, size_t maxSize);
+
+/** @brief Replace the file with the given content
+ *
+ *  The content is written to a temporary file of the same directory with a
+ *  single write, synced, then renamed over the file; readers and a crash
+ *  either see the former file or the complete new one, and the watches of
+ *  the file are notified once. The file keeps its permissions, if it exists.
+ *
+ *  @param[in] filePath - Path of the file to replace or create.
+ *  @param[in] content - New content of the file.
+ */
+void writeFileAtomically(const std::string& filePath, std::string_view content);
+
+/** @brief Create an empty file of unique name in the directory, so that the
+ *  name can't be taken by anyone else
+ *  @param[in] directoryPath - Directory path.
+ *  @return the file path
+ */
+std::string createUniqueFile(const std::string& directoryPath);
+
+/** @brief Create a directory of unique name in the directory
+ *  @param[in] directoryPath - Directory path.
+ *  @return the created directory path
+ */
+std::string createUniqueDirectory(const std::string& directoryPath);
+
+/** @brief Check whether the path is the temporary file of a write that never
+ *  completed, e.g. because of a crash
+ *  @param[in] path - Path of a file.
+ */
+bool isTemporaryFile(const std::filesystem::path& path);
+
+} // namespace phosphor::certs
@@ -0,0 +1,48 @@
+#include "install_job.hpp"
+
+#include <chrono>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+uint64_t nowInMilliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+} // namespace
+
+InstallJob::InstallJob(sdbusplus::bus_t& bus, const char* path) :
+    internal::InstallJobInterface(
+        bus, path, internal::InstallJobInterface::action::defer_emit)
+{
+    status(OperationStatus::InProgress, true);
+    startTime(nowInMilliseconds(), true);
+    // Emit deferred signal.
+    this->emit_object_added();
+}
+
+void InstallJob::complete()
+{
+    finish(OperationStatus::Completed);
+}
+
+void InstallJob::fail()
+{
+    finish(OperationStatus::Failed);
+}
+
+bool InstallJob::isInProgress() const
+{
+    return status() == OperationStatus::InProgress;
+}
+
+void InstallJob::finish(OperationStatus result)
+{
+    completedTime(nowInMilliseconds());
+    status(result);
+}
+} // namespace phosphor::certs
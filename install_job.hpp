@@ -0,0 +1,50 @@
+#pragma once
+#include <sdbusplus/server/object.hpp>
+#include <string>
+#include <xyz/openbmc_project/Common/Progress/server.hpp>
+
+namespace phosphor::certs
+{
+
+namespace internal
+{
+using InstallJobInterface = sdbusplus::server::object_t<
+    sdbusplus::xyz::openbmc_project::Common::server::Progress>;
+}
+
+/** @class InstallJob
+ *  @brief Progress of an asynchronous certificate install
+ *  @details The job is published at the object path reserved for the
+ *  certificate being installed; the Certificate interfaces show up next to it
+ *  once the install completes.
+ */
+class InstallJob : public internal::InstallJobInterface
+{
+  public:
+    InstallJob() = delete;
+    ~InstallJob() = default;
+    InstallJob(const InstallJob&) = delete;
+    InstallJob& operator=(const InstallJob&) = delete;
+    InstallJob(InstallJob&&) = delete;
+    InstallJob& operator=(InstallJob&&) = delete;
+
+    /** @brief Constructor to put object onto bus at a D-Bus path.
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - The D-Bus object path to attach at.
+     */
+    InstallJob(sdbusplus::bus_t& bus, const char* path);
+
+    /** @brief Mark the install as completed */
+    void complete();
+
+    /** @brief Mark the install as failed */
+    void fail();
+
+    /** @brief Whether the install is still running */
+    bool isInProgress() const;
+
+  private:
+    /** @brief Set the final |result| and the completion time */
+    void finish(OperationStatus result);
+};
+} // namespace phosphor::certs
@@ -0,0 +1,31 @@
+#include "log_rate_limiter.hpp"
+
+namespace phosphor::certs
+{
+
+LogRateLimiter::LogRateLimiter(Clock::duration interval) : interval(interval)
+{}
+
+std::optional<size_t> LogRateLimiter::admit(int key, Clock::time_point now)
+{
+    if (interval == Clock::duration::zero())
+    {
+        return 0;
+    }
+    std::lock_guard lock(mutex);
+    auto [state, inserted] = states.try_emplace(key, State{now, 0});
+    if (inserted)
+    {
+        return 0;
+    }
+    if (now - state->second.lastLogged < interval)
+    {
+        ++state->second.suppressed;
+        return std::nullopt;
+    }
+    size_t suppressed = state->second.suppressed;
+    state->second = State{now, 0};
+    return suppressed;
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace phosphor::certs
+{
+
+/** @class LogRateLimiter
+ *
+ *  @brief Let through at most one log record per key and interval
+ *
+ *  Records dropped in between are counted, so the next record let through
+ *  can tell how many were suppressed. Safe to use from any thread.
+ */
+class LogRateLimiter
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** @brief Constructor
+     *  @param[in] interval - Minimum time between two records of a key; zero
+     * lets every record through.
+     */
+    explicit LogRateLimiter(Clock::duration interval);
+
+    /** @brief Whether a record of |key| shall be logged at |now|
+     *  @param[in] key - What the record is about, e.g. an error code.
+     *  @param[in] now - Time of the record.
+     *  @return the number of records of |key| suppressed since the previous
+     * one logged, or nullopt if this one shall be suppressed.
+     */
+    std::optional<size_t> admit(int key, Clock::time_point now = Clock::now());
+
+  private:
+    /** @brief Last record logged and the records suppressed since */
+    struct State
+    {
+        Clock::time_point lastLogged;
+        size_t suppressed;
+    };
+
+    const Clock::duration interval;
+
+    /** @brief Guards |states|; validations run on worker threads */
+    std::mutex mutex;
+
+    std::unordered_map<int, State> states;
+};
+
+} // namespace phosphor::certs
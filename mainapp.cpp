@@ -23,11 +23,17 @@
 #include <systemd/sd-event.h>
 
 #include <cctype>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/manager.hpp>
 #include <sdeventplus/event.hpp>
 #include <string>
 #include <utility>
+#include <vector>
 
 inline std::string capitalize(const std::string& s)
 {
@@ -47,27 +53,69 @@ int main(int argc, char** argv)
         std::exit(EXIT_FAILURE);
     }
 
+    // Either the endpoint of the command line or every endpoint of the config
+    std::vector<phosphor::certs::Arguments> endpoints;
+    if (arguments.config.empty())
+    {
+        endpoints.push_back(std::move(arguments));
+    }
+    else
+    {
+        std::ifstream config(arguments.config);
+        if (!config.is_open())
+        {
+            std::cerr << "config " << arguments.config << " can't be read."
+                      << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        if (phosphor::certs::processConfig(config, endpoints) != 0)
+        {
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
     auto bus = sdbusplus::bus::new_default();
-    auto objPath = std::string(objectNamePrefix) + '/' + arguments.typeStr +
-                   '/' + arguments.endpoint;
-    // Add sdbusplus ObjectManager
-    sdbusplus::server::manager_t objManager(bus, objPath.c_str());
 
     // Get default event loop
     auto event = sdeventplus::Event::get_default();
 
     // Attach the bus to sd_event to service user requests
     bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
-    phosphor::certs::Manager manager(
-        bus, event, objPath.c_str(),
-        phosphor::certs::stringToCertificateType(arguments.typeStr),
-        arguments.unit, arguments.path);
 
-    // Adjusting Interface name as per std convention
-    auto busName = std::string(busNamePrefix) + '.' +
-                   capitalize(arguments.typeStr) + '.' +
-                   capitalize(arguments.endpoint);
-    bus.request_name(busName.c_str());
+    // The managers share the connection, the event loop and the caches of
+    // the process
+    std::vector<std::unique_ptr<sdbusplus::server::manager_t>> objManagers;
+    std::vector<std::unique_ptr<phosphor::certs::Manager>> managers;
+    for (const auto& endpoint : endpoints)
+    {
+        auto objPath = std::string(objectNamePrefix) + '/' + endpoint.typeStr +
+                       '/' + endpoint.endpoint;
+        // Add sdbusplus ObjectManager
+        objManagers.emplace_back(std::make_unique<sdbusplus::server::manager_t>(
+            bus, objPath.c_str()));
+        managers.emplace_back(std::make_unique<phosphor::certs::Manager>(
+            bus, event, objPath.c_str(),
+            phosphor::certs::stringToCertificateType(endpoint.typeStr),
+            endpoint.unit, endpoint.path));
+
+        // Adjusting Interface name as per std convention
+        auto busName = std::string(busNamePrefix) + '.' +
+                       capitalize(endpoint.typeStr) + '.' +
+                       capitalize(endpoint.endpoint);
+        bus.request_name(busName.c_str());
+    }
     event.loop();
+    // The managers don't reload the units of batched changes when destroyed
+    for (auto& manager : managers)
+    {
+        try
+        {
+            manager->flushReload();
+        }
+        catch (const std::exception& e)
+        {
+            // Logged by the manager already
+        }
+    }
     return 0;
 }
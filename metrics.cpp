@@ -0,0 +1,147 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+constexpr std::array<const char*, 8> operationNames = {
+    "Install",       "InstallAll",    "ReplaceAll",
+    "DeleteAll",     "GenerateCSR",   "CSRGeneration",
+    "WatchCallback", "ReloadOrReset",
+};
+
+// Validations run on the worker threads of every manager of the process
+std::mutex validationFailuresMutex;
+std::map<int32_t, uint64_t> validationFailures;
+
+} // namespace
+
+const sdbusplus::vtable_t Metrics::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method("GetDurations", "", "a{s(tttat)}",
+                              Metrics::callGetDurations),
+    sdbusplus::vtable::method("GetValidationFailures", "", "a{it}",
+                              Metrics::callGetValidationFailures),
+    sdbusplus::vtable::end()};
+
+Metrics::Timer::Timer(Metrics& metrics, Operation operation) :
+    metrics(metrics), operation(operation), start(Clock::now())
+{}
+
+Metrics::Timer::~Timer()
+{
+    metrics.record(operation, Clock::now() - start);
+}
+
+Metrics::Metrics(sdbusplus::bus_t& bus, const char* path) :
+    metricsInterface(bus, path, metricsInterfaceName, vtable, this)
+{}
+
+void Metrics::record(Operation operation, Clock::duration duration)
+{
+    auto us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count());
+    size_t bucket = static_cast<size_t>(
+        std::lower_bound(durationBucketBounds.begin(),
+                         durationBucketBounds.end(), us) -
+        durationBucketBounds.begin());
+
+    std::lock_guard lock(mutex);
+    Histogram& histogram = histograms[static_cast<size_t>(operation)];
+    ++histogram.count;
+    histogram.totalUs += us;
+    histogram.maxUs = std::max(histogram.maxUs, us);
+    ++histogram.buckets[bucket];
+}
+
+std::map<std::string, Metrics::DurationStats> Metrics::getDurations() const
+{
+    std::map<std::string, DurationStats> durations;
+    std::lock_guard lock(mutex);
+    for (size_t i = 0; i < numOperations; ++i)
+    {
+        const Histogram& histogram = histograms[i];
+        durations.emplace(
+            operationNames[i],
+            DurationStats(histogram.count, histogram.totalUs, histogram.maxUs,
+                          std::vector<uint64_t>(histogram.buckets.begin(),
+                                                histogram.buckets.end())));
+    }
+    return durations;
+}
+
+void Metrics::recordValidationFailure(int x509Error)
+{
+    std::lock_guard lock(validationFailuresMutex);
+    ++validationFailures[x509Error];
+}
+
+std::map<int32_t, uint64_t> Metrics::getValidationFailures()
+{
+    std::lock_guard lock(validationFailuresMutex);
+    return validationFailures;
+}
+
+int Metrics::callGetDurations(sd_bus_message* msg, void* context,
+                              sd_bus_error* error)
+{
+    auto metrics = static_cast<Metrics*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        auto reply = call.new_method_return();
+        reply.append(metrics->getDurations());
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        // Unwinding through the sd-bus callback would abort the daemon
+        log<level::ERR>("Failed to handle the metrics call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+int Metrics::callGetValidationFailures(sd_bus_message* msg, void*,
+                                       sd_bus_error* error)
+{
+    try
+    {
+        sdbusplus::message_t call(msg);
+        auto reply = call.new_method_return();
+        reply.append(getValidationFailures());
+        reply.method_return();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to handle the metrics call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+} // namespace phosphor::certs
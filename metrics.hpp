@@ -0,0 +1,145 @@
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @brief Interface exposing the metrics of a manager */
+inline constexpr char metricsInterfaceName[] =
+    "xyz.openbmc_project.Certs.Metrics";
+
+/** @brief Operations of the manager whose durations are tracked */
+enum class Operation
+{
+    install,
+    installAll,
+    replaceAll,
+    deleteAll,
+    generateCSR,
+    csrGeneration,
+    watchCallback,
+    reloadOrReset,
+};
+
+/** @class Metrics
+ *
+ *  @brief Duration histograms of the manager operations, served on D-Bus
+ *
+ *  Durations are measured on the monotonic clock and may be recorded from
+ *  any thread. The interface has two methods:
+ *  - GetDurations() -> a{s(tttat)}: for each operation, the number of
+ *    calls, their total and maximum durations in microseconds, then the
+ *    number of calls of each bucket of durationBucketBounds; the last
+ *    bucket has no bound.
+ *  - GetValidationFailures() -> a{it}: the number of certificate
+ *    validations of the process that failed, by X509 error code.
+ */
+class Metrics
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** @brief Number of calls, total and maximum durations in microseconds,
+     *  then the number of calls of each bucket
+     */
+    using DurationStats =
+        std::tuple<uint64_t, uint64_t, uint64_t, std::vector<uint64_t>>;
+
+    /** @brief Upper bounds of the duration buckets, in microseconds */
+    static constexpr std::array<uint64_t, 6> durationBucketBounds = {
+        100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000};
+
+    /** @class Timer
+     *
+     *  @brief Records the duration of an operation when it goes away
+     */
+    class Timer
+    {
+      public:
+        Timer(Metrics& metrics, Operation operation);
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+        Timer(Timer&&) = delete;
+        Timer& operator=(Timer&&) = delete;
+        ~Timer();
+
+      private:
+        Metrics& metrics;
+        Operation operation;
+        Clock::time_point start;
+    };
+
+    /** @brief ctor - put the metrics interface onto the bus
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - Path of the manager.
+     */
+    Metrics(sdbusplus::bus_t& bus, const char* path);
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics(Metrics&&) = delete;
+    Metrics& operator=(Metrics&&) = delete;
+
+    /** @brief Record the duration of one call of the operation
+     *  @param[in] operation - The operation.
+     *  @param[in] duration - How long the call took.
+     */
+    void record(Operation operation, Clock::duration duration);
+
+    /** @brief Get the duration histograms, by operation name */
+    std::map<std::string, DurationStats> getDurations() const;
+
+    /** @brief Count a failed certificate validation of the process
+     *  @param[in] x509Error - The X509_V_ERR_* code of the failure.
+     */
+    static void recordValidationFailure(int x509Error);
+
+    /** @brief Get the failed certificate validations of the process, by
+     *  X509 error code
+     */
+    static std::map<int32_t, uint64_t> getValidationFailures();
+
+  private:
+    static constexpr size_t numOperations =
+        static_cast<size_t>(Operation::reloadOrReset) + 1;
+
+    struct Histogram
+    {
+        uint64_t count = 0;
+        uint64_t totalUs = 0;
+        uint64_t maxUs = 0;
+        std::array<uint64_t, durationBucketBounds.size() + 1> buckets{};
+    };
+
+    /** @brief D-Bus handlers of the metrics interface */
+    static int callGetDurations(sd_bus_message* msg, void* context,
+                                sd_bus_error* error);
+    static int callGetValidationFailures(sd_bus_message* msg, void* context,
+                                         sd_bus_error* error);
+
+    /** @brief Methods of the metrics interface */
+    static const sdbusplus::vtable_t vtable[];
+
+    /** @brief Guards |histograms|; CSRs are generated on a worker thread */
+    mutable std::mutex mutex;
+
+    /** @brief Duration histograms, by operation */
+    std::array<Histogram, numOperations> histograms{};
+
+    /** @brief The metrics interface */
+    sdbusplus::server::interface_t metricsInterface;
+};
+
+} // namespace phosphor::certs
@@ -0,0 +1,77 @@
+#include "reload_control.hpp"
+
+#include "certs_manager.hpp"
+
+#include <exception>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+} // namespace
+
+const sdbusplus::vtable_t ReloadControl::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method("Flush", "", "", ReloadControl::callFlush),
+    sdbusplus::vtable::end()};
+
+ReloadControl::ReloadControl(sdbusplus::bus_t& bus, const char* path,
+                             Manager& manager) :
+    manager(manager),
+    reloadControlInterface(bus, path, reloadControlInterfaceName, vtable, this)
+{}
+
+int ReloadControl::callFlush(sd_bus_message* msg, void* context,
+                             sd_bus_error* error)
+{
+    auto reloadControl = static_cast<ReloadControl*>(context);
+    try
+    {
+        sdbusplus::message_t call(msg);
+        reloadControl->manager.flushReload();
+        // The call holds a reference to the message until it's answered
+        reloadControl->manager.waitForReloads(
+            [call](bool succeeded) mutable {
+                try
+                {
+                    auto reply = succeeded
+                                     ? call.new_method_return()
+                                     : call.new_method_error(InternalFailure());
+                    reply.method_return();
+                }
+                catch (const sdbusplus::exception_t& e)
+                {
+                    // The caller left the bus
+                }
+                catch (const std::exception& e)
+                {
+                    // Runs from the reply callback of the last reload
+                    log<level::ERR>("Failed to answer the reload flush call",
+                                    entry("ERR=%s", e.what()));
+                }
+            });
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        // Unwinding through the sd-bus callback would abort the daemon
+        log<level::ERR>("Failed to handle the reload flush call",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+} // namespace phosphor::certs
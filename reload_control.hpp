@@ -0,0 +1,59 @@
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+
+namespace phosphor::certs
+{
+
+/** @brief Interface flushing the batched reloads of the unit consuming the
+ *  certificates of a manager
+ */
+inline constexpr char reloadControlInterfaceName[] =
+    "xyz.openbmc_project.Certs.ReloadControl";
+
+class Manager; // Forward declaration for Certificate Manager.
+
+/** @class ReloadControl
+ *
+ *  @brief Lets clients apply their changes to the unit right away
+ *
+ *  Changes only reach the unit with the reload closing the batching window.
+ *  The interface, at the manager object path, has the method Flush(),
+ *  requesting the reload of a waiting change now. Its reply is deferred until
+ *  systemd answered every reload the manager requested, so it returns with
+ *  the changes applied; it fails with InternalFailure if a reload couldn't
+ *  be requested or systemd rejected one.
+ */
+class ReloadControl
+{
+  public:
+    /** @brief ctor - put the interface onto the bus
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - Path of the manager.
+     *  @param[in] manager - The manager reloading the unit.
+     */
+    ReloadControl(sdbusplus::bus_t& bus, const char* path, Manager& manager);
+    ReloadControl(const ReloadControl&) = delete;
+    ReloadControl& operator=(const ReloadControl&) = delete;
+    ReloadControl(ReloadControl&&) = delete;
+    ReloadControl& operator=(ReloadControl&&) = delete;
+    ~ReloadControl() = default;
+
+  private:
+    /** @brief D-Bus handler of Flush */
+    static int callFlush(sd_bus_message* msg, void* context,
+                         sd_bus_error* error);
+
+    /** @brief Methods of the interface */
+    static const sdbusplus::vtable_t vtable[];
+
+    Manager& manager;
+
+    /** @brief The reload control interface */
+    sdbusplus::server::interface_t reloadControlInterface;
+};
+
+} // namespace phosphor::certs
@@ -0,0 +1,278 @@
+#include "config.h"
+
+#include "store_index.hpp"
+
+#include "file_utils.hpp"
+
+#include <sys/stat.h>
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <phosphor-logging/log.hpp>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace fs = std::filesystem;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+namespace
+{
+// First line of the index; bump it whenever the entry layout changes
+constexpr std::string_view indexHeader = "phosphor-certificate-manager v1";
+constexpr size_t numFields = 12;
+
+fs::path indexPath(const fs::path& storeDir)
+{
+    return storeDir / defaultStoreIndexFileName;
+}
+
+// Fields are tab separated and entries newline separated
+std::string escape(std::string_view field)
+{
+    std::string escaped;
+    escaped.reserve(field.size());
+    for (char c : field)
+    {
+        switch (c)
+        {
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped += c;
+        }
+    }
+    return escaped;
+}
+
+bool unescape(std::string_view field, std::string& value)
+{
+    value.clear();
+    value.reserve(field.size());
+    for (size_t i = 0; i < field.size(); ++i)
+    {
+        if (field[i] != '\\')
+        {
+            value += field[i];
+            continue;
+        }
+        if (++i == field.size())
+        {
+            return false;
+        }
+        switch (field[i])
+        {
+            case '\\':
+                value += '\\';
+                break;
+            case 't':
+                value += '\t';
+                break;
+            case 'n':
+                value += '\n';
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool parseNumber(std::string_view field, T& value)
+{
+    auto [ptr, ec] =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() && ptr == field.data() + field.size();
+}
+
+std::vector<std::string_view> split(std::string_view line, char separator)
+{
+    std::vector<std::string_view> fields;
+    size_t begin = 0;
+    while (true)
+    {
+        size_t end = line.find(separator, begin);
+        if (end == std::string_view::npos)
+        {
+            fields.emplace_back(line.substr(begin));
+            return fields;
+        }
+        fields.emplace_back(line.substr(begin, end - begin));
+        begin = end + 1;
+    }
+}
+
+bool parseEntry(std::string_view line, StoreIndexEntry& entry)
+{
+    std::vector<std::string_view> fields = split(line, '\t');
+    if (fields.size() != numFields)
+    {
+        return false;
+    }
+    if (!unescape(fields[0], entry.fileName) ||
+        !parseNumber(fields[1], entry.fileSize) ||
+        !parseNumber(fields[2], entry.fileTime) ||
+        !unescape(fields[3], entry.certId) ||
+        !unescape(fields[4], entry.subjectNameHash) ||
+        !unescape(fields[5], entry.fingerprint) ||
+        !unescape(fields[6], entry.subject) ||
+        !unescape(fields[7], entry.issuer) ||
+        !parseNumber(fields[8], entry.validNotBefore) ||
+        !parseNumber(fields[9], entry.validNotAfter) ||
+        !unescape(fields[11], entry.certificateString))
+    {
+        return false;
+    }
+    // Key usage names are plain identifiers and need no escaping
+    entry.keyUsage.clear();
+    if (!fields[10].empty())
+    {
+        for (std::string_view usage : split(fields[10], ','))
+        {
+            entry.keyUsage.emplace_back(usage);
+        }
+    }
+    return !entry.fileName.empty();
+}
+
+void writeEntry(std::ostream& stream, const StoreIndexEntry& entry)
+{
+    stream << escape(entry.fileName) << '\t' << entry.fileSize << '\t'
+           << entry.fileTime << '\t' << escape(entry.certId) << '\t'
+           << escape(entry.subjectNameHash) << '\t'
+           << escape(entry.fingerprint) << '\t' << escape(entry.subject)
+           << '\t' << escape(entry.issuer) << '\t' << entry.validNotBefore
+           << '\t' << entry.validNotAfter << '\t';
+    for (size_t i = 0; i < entry.keyUsage.size(); ++i)
+    {
+        stream << (i == 0 ? "" : ",") << entry.keyUsage[i];
+    }
+    stream << '\t' << escape(entry.certificateString) << '\n';
+}
+} // namespace
+
+bool statStoreFile(const fs::path& storeDir, StoreIndexEntry& entry)
+{
+    struct stat st;
+    if (stat((storeDir / entry.fileName).c_str(), &st) != 0)
+    {
+        return false;
+    }
+    entry.fileSize = static_cast<uintmax_t>(st.st_size);
+    entry.fileTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                     st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool isStoreFileUnchanged(const fs::path& storeDir,
+                          const StoreIndexEntry& entry)
+{
+    StoreIndexEntry current;
+    current.fileName = entry.fileName;
+    return statStoreFile(storeDir, current) &&
+           current.fileSize == entry.fileSize &&
+           current.fileTime == entry.fileTime;
+}
+
+bool isRestorableFromIndex(const fs::path& storeDir,
+                           const StoreIndexEntry& entry)
+{
+    if (!isStoreFileUnchanged(storeDir, entry))
+    {
+        return false;
+    }
+    if constexpr (!allowExpired)
+    {
+        // The validation would reject it now
+        uint64_t now = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count());
+        return !entry.isCertificate() || entry.validNotAfter >= now;
+    }
+    return true;
+}
+
+bool isStoreIndexFile(const fs::path& path)
+{
+    return path.filename() == defaultStoreIndexFileName;
+}
+
+std::vector<StoreIndexEntry> readStoreIndex(const fs::path& storeDir)
+{
+    std::ifstream indexStream(indexPath(storeDir));
+    if (!indexStream.is_open())
+    {
+        return {};
+    }
+
+    std::string line;
+    if (!std::getline(indexStream, line) || line != indexHeader)
+    {
+        log<level::INFO>("Ignoring store index of an unknown format",
+                         entry("DIR=%s", storeDir.c_str()));
+        return {};
+    }
+
+    std::vector<StoreIndexEntry> entries;
+    while (std::getline(indexStream, line))
+    {
+        if (!parseEntry(line, entries.emplace_back()))
+        {
+            log<level::ERR>("Ignoring corrupted store index",
+                            entry("DIR=%s", storeDir.c_str()),
+                            entry("ENTRY=%zu", entries.size()));
+            return {};
+        }
+    }
+    return entries;
+}
+
+void writeStoreIndex(const fs::path& storeDir,
+                     const std::vector<StoreIndexEntry>& entries)
+{
+    std::error_code ec;
+    if (entries.empty())
+    {
+        fs::remove(indexPath(storeDir), ec);
+        return;
+    }
+
+    std::ostringstream indexStream;
+    indexStream << indexHeader << '\n';
+    for (const auto& indexEntry : entries)
+    {
+        writeEntry(indexStream, indexEntry);
+    }
+    try
+    {
+        // Replace the index at once so neither a crash nor a power loss
+        // leaves half of it
+        writeFileAtomically(indexPath(storeDir), indexStream.str());
+    }
+    catch (const InternalFailure& e)
+    {
+        log<level::ERR>("Failed to write store index",
+                        entry("DIR=%s", storeDir.c_str()));
+        // A stale index would still be trusted at the next start
+        fs::remove(indexPath(storeDir), ec);
+    }
+}
+
+} // namespace phosphor::certs
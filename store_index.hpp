@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @brief What the authority store index keeps about a file of the store
+ *
+ *  Entries of certificate files carry the certificate identifiers and the
+ *  D-Bus properties published for it, so an unchanged file can be restored
+ *  without parsing nor validating it again. Entries of other files, e.g. the
+ *  authorities list, only carry the file name, size and time.
+ */
+struct StoreIndexEntry
+{
+    /** @brief name of the file in the store directory */
+    std::string fileName;
+    /** @brief file size in bytes */
+    uintmax_t fileSize = 0;
+    /** @brief file modification time, in file clock ticks */
+    int64_t fileTime = 0;
+
+    std::string certId;
+    std::string subjectNameHash;
+    std::string fingerprint;
+    std::string subject;
+    std::string issuer;
+    uint64_t validNotBefore = 0;
+    uint64_t validNotAfter = 0;
+    std::vector<std::string> keyUsage;
+    std::string certificateString;
+
+    /** @brief Whether the entry describes a certificate file */
+    bool isCertificate() const
+    {
+        return !certId.empty();
+    }
+};
+
+/** @brief Fill the file size and time of |entry| from the file of the store
+ *  @param[in] storeDir - Store directory.
+ *  @param[in,out] entry - Entry whose file name is set.
+ *  @return false if the file can't be found
+ */
+bool statStoreFile(const std::filesystem::path& storeDir,
+                   StoreIndexEntry& entry);
+
+/** @brief Check the file of |entry| is unchanged since it was indexed
+ *  @param[in] storeDir - Store directory.
+ *  @param[in] entry - Index entry.
+ *  @return true if the file has the indexed size and time
+ */
+bool isStoreFileUnchanged(const std::filesystem::path& storeDir,
+                          const StoreIndexEntry& entry);
+
+/** @brief Check |entry| can be restored without validating its file again
+ *  @param[in] storeDir - Store directory.
+ *  @param[in] entry - Index entry.
+ *  @return true if the file is unchanged since it was indexed and, unless
+ *  expired certificates are allowed, the certificate hasn't expired since
+ */
+bool isRestorableFromIndex(const std::filesystem::path& storeDir,
+                           const StoreIndexEntry& entry);
+
+/** @brief Check whether the path is the index of its store rather than a
+ *  certificate file
+ *  @param[in] path - Path of a file of the store.
+ */
+bool isStoreIndexFile(const std::filesystem::path& path);
+
+/** @brief Read the index of the store
+ *  @param[in] storeDir - Store directory.
+ *  @return the index entries; empty if there is no usable index
+ */
+std::vector<StoreIndexEntry>
+    readStoreIndex(const std::filesystem::path& storeDir);
+
+/** @brief Replace the index of the store; the index is only a cache, so
+ *  failures are logged and leave no index behind rather than throwing
+ *  @param[in] storeDir - Store directory.
+ *  @param[in] entries - Index entries; the index is removed if empty.
+ */
+void writeStoreIndex(const std::filesystem::path& storeDir,
+                     const std::vector<StoreIndexEntry>& entries);
+
+} // namespace phosphor::certs
@@ -0,0 +1,184 @@
+#include "bmc-acf/acf_manager.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sdbusplus/bus.hpp>
+#include <sdeventplus/event.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace acf::cert
+{
+namespace
+{
+namespace fs = std::filesystem;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgReferee;
+
+class MockACFCertMgr : public ACFCertMgr
+{
+  public:
+    using ACFCertMgr::ACFCertMgr;
+
+    MOCK_METHOD(int, verifyACF, (std::vector<uint8_t>&, std::string&),
+                (override));
+    MOCK_METHOD(int, writeACF, (std::vector<uint8_t>&, std::string&),
+                (override));
+
+    std::chrono::system_clock::time_point now() const override
+    {
+        return fakeNow;
+    }
+
+    /** @brief Time the manager sees instead of the system clock */
+    std::chrono::system_clock::time_point fakeNow =
+        std::chrono::sys_days(std::chrono::year(2030) / 1 / 1) +
+        std::chrono::hours(12);
+};
+
+class TestACFCertMgr : public ::testing::Test
+{
+  public:
+    TestACFCertMgr() : bus(sdbusplus::bus::new_default())
+    {
+    }
+
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/FakeACF.XXXXXX";
+        auto dirPtr = mkdtemp(dirTemplate);
+        if (dirPtr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        acfDir = dirPtr;
+        acfFile = (acfDir / "service.acf").string();
+        writeACFFile("first ACF");
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(acfDir);
+    }
+
+  protected:
+    void writeACFFile(const std::string& content)
+    {
+        std::ofstream stream(acfFile, std::ios::binary | std::ios::trunc);
+        stream << content;
+    }
+
+    static std::vector<uint8_t> bytes(const std::string& content)
+    {
+        return {content.begin(), content.end()};
+    }
+
+    // Runs the event loop for |duration| at least
+    void runFor(std::chrono::milliseconds duration)
+    {
+        auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until)
+        {
+            event.run(std::chrono::milliseconds(10));
+        }
+    }
+
+    sdbusplus::bus_t bus;
+    sdeventplus::Event event = sdeventplus::Event::get_default();
+    fs::path acfDir;
+    std::string acfFile;
+    static constexpr auto objPath = "/xyz/openbmc_project/certs/ACF";
+    static constexpr auto date = "2030-12-31";
+};
+
+TEST_F(TestACFCertMgr, VerifiedOnceUntilInstall)
+{
+    MockACFCertMgr manager(bus, event, objPath, acfFile);
+    EXPECT_CALL(manager, verifyACF(_, _))
+        .WillOnce(DoAll(SetArgReferee<1>(date), Return(0)));
+    acf_info info = manager.getACFInfo();
+    EXPECT_EQ(std::get<0>(info), bytes("first ACF"));
+    EXPECT_TRUE(std::get<1>(info));
+    EXPECT_EQ(std::get<2>(info), date);
+    EXPECT_EQ(manager.getACFInfo(), info);
+    ::testing::Mock::VerifyAndClearExpectations(&manager);
+
+    // The install result replaces the cached one; its own write of the file
+    // doesn't drop it
+    EXPECT_CALL(manager, verifyACF(_, _)).Times(0);
+    EXPECT_CALL(manager, writeACF(_, _))
+        .WillOnce([this](std::vector<uint8_t>&, std::string& installDate) {
+            writeACFFile("second ACF");
+            installDate = date;
+            return 0;
+        });
+    manager.installACF(bytes("second ACF"));
+    runFor(std::chrono::milliseconds(300));
+    info = manager.getACFInfo();
+    EXPECT_EQ(std::get<0>(info), bytes("second ACF"));
+    EXPECT_EQ(std::get<2>(info), date);
+}
+
+TEST_F(TestACFCertMgr, ExternalWriteDropsCachedResult)
+{
+    MockACFCertMgr manager(bus, event, objPath, acfFile);
+    EXPECT_CALL(manager, verifyACF(_, _))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgReferee<1>(date), Return(0)));
+    EXPECT_EQ(std::get<0>(manager.getACFInfo()), bytes("first ACF"));
+
+    writeACFFile("written by another tool");
+    runFor(std::chrono::milliseconds(300));
+    EXPECT_EQ(std::get<0>(manager.getACFInfo()),
+              bytes("written by another tool"));
+    EXPECT_EQ(std::get<0>(manager.getACFInfo()),
+              bytes("written by another tool"));
+}
+
+TEST_F(TestACFCertMgr, DeletionIsSeenWithoutTheWatch)
+{
+    MockACFCertMgr manager(bus, event, objPath, acfFile);
+    EXPECT_CALL(manager, verifyACF(_, _))
+        .WillOnce(DoAll(SetArgReferee<1>(date), Return(0)));
+    EXPECT_TRUE(std::get<1>(manager.getACFInfo()));
+
+    // Deletions don't reach the watch, and the loop doesn't even run
+    fs::remove(acfFile);
+    acf_info info = manager.getACFInfo();
+    EXPECT_TRUE(std::get<0>(info).empty());
+    EXPECT_FALSE(std::get<1>(info));
+    EXPECT_TRUE(std::get<2>(info).empty());
+}
+
+TEST_F(TestACFCertMgr, CachedResultExpiresWithTheDay)
+{
+    using namespace std::chrono;
+    MockACFCertMgr manager(bus, event, objPath, acfFile);
+    manager.fakeNow = sys_days(year(2030) / 6 / 30) + hours(23) + minutes(59);
+    EXPECT_CALL(manager, verifyACF(_, _))
+        .WillOnce(DoAll(SetArgReferee<1>(date), Return(0)));
+    manager.getACFInfo();
+    manager.fakeNow += seconds(59);
+    manager.getACFInfo();
+    ::testing::Mock::VerifyAndClearExpectations(&manager);
+
+    // The ACF may have expired with the day; the next one is verified again
+    EXPECT_CALL(manager, verifyACF(_, _))
+        .WillOnce(DoAll(SetArgReferee<1>(date), Return(0)));
+    manager.fakeNow += seconds(1);
+    manager.getACFInfo();
+    manager.getACFInfo();
+}
+
+} // namespace
+} // namespace acf::cert
@@ -1,5 +1,6 @@
 #include "argument.hpp"
 
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -106,6 +107,52 @@ TEST(Path, MissPathThrows)
                                      "abc",    "--unit", "ghi"};
     EXPECT_NE(processArguments(argv.size(), argv.data(), arguments), 0);
 }
+TEST(Config, ConfigReplacesEndpointArguments)
+{
+    Arguments arguments;
+    std::vector<const char*> argv = {"binary", "--config", "endpoints"};
+    EXPECT_EQ(processArguments(argv.size(), argv.data(), arguments), 0);
+    EXPECT_EQ(arguments.config, "endpoints");
+}
+
+TEST(Config, ConfigWithEndpointArgumentsThrows)
+{
+    Arguments arguments;
+    std::vector<const char*> argv = {"binary", "--config", "endpoints",
+                                     "--type", "client"};
+    EXPECT_NE(processArguments(argv.size(), argv.data(), arguments), 0);
+}
+
+TEST(Config, OnSuccessSeveralEndpoints)
+{
+    std::istringstream config("# type endpoint path unit\n"
+                              "server https /etc/ssl/https/server.pem ghi\n"
+                              "\n"
+                              "  authority   ldap /etc/ssl/authority\n");
+    std::vector<Arguments> endpoints;
+    EXPECT_EQ(processConfig(config, endpoints), 0);
+    ASSERT_EQ(endpoints.size(), 2);
+    EXPECT_EQ(endpoints[0].typeStr, "server");
+    EXPECT_EQ(endpoints[0].endpoint, "https");
+    EXPECT_EQ(endpoints[0].path, "/etc/ssl/https/server.pem");
+    EXPECT_EQ(endpoints[0].unit, "ghi");
+    EXPECT_EQ(endpoints[1].typeStr, "authority");
+    EXPECT_EQ(endpoints[1].endpoint, "ldap");
+    EXPECT_EQ(endpoints[1].path, "/etc/ssl/authority");
+    EXPECT_TRUE(endpoints[1].unit.empty());
+}
+
+TEST(Config, InvalidEndpointsThrow)
+{
+    for (const char* line :
+         {"", "no-supported abc def", "client abc", "client abc def ghi jkl",
+          "client abc def\nclient abc xyz"})
+    {
+        std::istringstream config(line);
+        std::vector<Arguments> endpoints;
+        EXPECT_NE(processConfig(config, endpoints), 0) << line;
+    }
+}
 } // namespace
 
 } // namespace phosphor::certs
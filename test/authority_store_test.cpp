@@ -0,0 +1,180 @@
+#include "authority_store.hpp"
+#include "x509_utils.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <xyz/openbmc_project/Certs/error.hpp>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+using ::sdbusplus::xyz::openbmc_project::Certs::Error::InvalidCertificate;
+using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
+using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
+
+/** @brief A certificate and its key */
+struct Identity
+{
+    EVPPkeyPtr key{EVP_EC_gen("P-256"), ::EVP_PKEY_free};
+    X509Ptr cert{X509_new(), ::X509_free};
+};
+
+/** @brief Create a certificate issued by |issuer|, or self-signed if null */
+Identity createIdentity(const std::string& cn, const Identity* issuer,
+                        bool isCA)
+{
+    Identity identity;
+    X509* cert = identity.cert.get();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 365L * 24 * 3600);
+    X509_set_pubkey(cert, identity.key.get());
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>(cn.c_str()), -1, -1, 0);
+    X509* issuerCert = issuer ? issuer->cert.get() : cert;
+    X509_set_issuer_name(cert, X509_get_subject_name(issuerCert));
+
+    X509V3_CTX ctx;
+    X509V3_set_ctx(&ctx, issuerCert, cert, nullptr, nullptr, 0);
+    for (auto [nid, value] :
+         {std::pair{NID_basic_constraints,
+                    isCA ? "critical,CA:TRUE" : "critical,CA:FALSE"},
+          std::pair{NID_key_usage, isCA ? "critical,keyCertSign,cRLSign"
+                                        : "critical,digitalSignature"}})
+    {
+        X509_EXTENSION* ext = X509V3_EXT_conf_nid(nullptr, &ctx, nid, value);
+        X509_add_ext(cert, ext, -1);
+        X509_EXTENSION_free(ext);
+    }
+    X509_sign(cert, issuer ? issuer->key.get() : identity.key.get(),
+              EVP_sha256());
+    return identity;
+}
+
+class AuthorityStoreTest : public ::testing::Test
+{
+  protected:
+    Identity root = createIdentity("root", nullptr, true);
+    Identity otherRoot = createIdentity("other root", nullptr, true);
+    Identity leaf = createIdentity("leaf", &root, false);
+    Identity otherLeaf = createIdentity("other leaf", &otherRoot, false);
+    AuthorityStore store;
+};
+
+TEST_F(AuthorityStoreTest, EmptyStoreHasNoStore)
+{
+    EXPECT_EQ(store.get(), nullptr);
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST_F(AuthorityStoreTest, LeavesOfAddedAuthoritiesAreValid)
+{
+    store.add(generateFingerprint(*root.cert), *root.cert);
+    ASSERT_NE(store.get(), nullptr);
+    EXPECT_EQ(store.size(), 1);
+    EXPECT_NO_THROW(validateCertificateChain(*store.get(), *leaf.cert, {}));
+    EXPECT_THROW(validateCertificateChain(*store.get(), *otherLeaf.cert, {}),
+                 InvalidCertificate);
+
+    // The store is extended in place
+    std::shared_ptr<X509_STORE> former = store.get();
+    store.add(generateFingerprint(*otherRoot.cert), *otherRoot.cert);
+    EXPECT_EQ(store.get(), former);
+    EXPECT_NO_THROW(
+        validateCertificateChain(*store.get(), *otherLeaf.cert, {}));
+}
+
+TEST_F(AuthorityStoreTest, SelfSignedCertificatesAreNotTrusted)
+{
+    store.add(generateFingerprint(*root.cert), *root.cert);
+    EXPECT_THROW(validateCertificateChain(*store.get(), *otherRoot.cert, {}),
+                 InvalidCertificate);
+}
+
+TEST_F(AuthorityStoreTest, RemovedAuthorityIsNoLongerTrusted)
+{
+    store.add(generateFingerprint(*root.cert), *root.cert);
+    store.add(generateFingerprint(*otherRoot.cert), *otherRoot.cert);
+    std::shared_ptr<X509_STORE> former = store.get();
+
+    store.remove({generateFingerprint(*root.cert)});
+    EXPECT_EQ(store.size(), 1);
+    ASSERT_NE(store.get(), nullptr);
+    EXPECT_NE(store.get(), former);
+    EXPECT_THROW(validateCertificateChain(*store.get(), *leaf.cert, {}),
+                 InvalidCertificate);
+    EXPECT_NO_THROW(
+        validateCertificateChain(*store.get(), *otherLeaf.cert, {}));
+    // Validations holding the former store carry on with it
+    EXPECT_NO_THROW(validateCertificateChain(*former, *leaf.cert, {}));
+
+    store.remove({generateFingerprint(*otherRoot.cert)});
+    EXPECT_EQ(store.get(), nullptr);
+}
+
+TEST_F(AuthorityStoreTest, AuthorityStaysUntilRemovedByEveryManager)
+{
+    std::string fingerprint = generateFingerprint(*root.cert);
+    store.add(fingerprint, *root.cert);
+    store.add(fingerprint, *root.cert);
+    EXPECT_EQ(store.size(), 1);
+    store.remove({fingerprint});
+    ASSERT_NE(store.get(), nullptr);
+    EXPECT_NO_THROW(validateCertificateChain(*store.get(), *leaf.cert, {}));
+    store.remove({fingerprint});
+    EXPECT_EQ(store.get(), nullptr);
+}
+
+TEST_F(AuthorityStoreTest, BatchRemovalCountsEveryOccurrence)
+{
+    std::string fingerprint = generateFingerprint(*root.cert);
+    std::string otherFingerprint = generateFingerprint(*otherRoot.cert);
+    store.add(fingerprint, *root.cert);
+    store.add(fingerprint, *root.cert);
+    store.add(otherFingerprint, *otherRoot.cert);
+    store.add(otherFingerprint, *otherRoot.cert);
+
+    // One drops, the other is still held by a manager
+    store.remove({fingerprint, otherFingerprint, fingerprint});
+    EXPECT_EQ(store.size(), 1);
+    ASSERT_NE(store.get(), nullptr);
+    EXPECT_THROW(validateCertificateChain(*store.get(), *leaf.cert, {}),
+                 InvalidCertificate);
+    EXPECT_NO_THROW(
+        validateCertificateChain(*store.get(), *otherLeaf.cert, {}));
+
+    store.remove({otherFingerprint, otherFingerprint});
+    EXPECT_EQ(store.size(), 0);
+    EXPECT_EQ(store.get(), nullptr);
+}
+
+TEST_F(AuthorityStoreTest, IntermediatesCompleteTheChain)
+{
+    Identity intermediate = createIdentity("intermediate", &root, true);
+    Identity server = createIdentity("server", &intermediate, false);
+    store.add(generateFingerprint(*root.cert), *root.cert);
+    EXPECT_THROW(validateCertificateChain(*store.get(), *server.cert, {}),
+                 InvalidCertificate);
+
+    std::vector<X509Ptr> chain;
+    chain.emplace_back(nullptr, ::X509_free);
+    X509_up_ref(intermediate.cert.get());
+    chain.emplace_back(intermediate.cert.get(), ::X509_free);
+    EXPECT_NO_THROW(
+        validateCertificateChain(*store.get(), *server.cert, chain));
+}
+
+} // namespace
+} // namespace phosphor::certs
@@ -2,8 +2,15 @@
 
 #include "bmc-vmi-ca/ca_certs_manager.hpp"
 
+#include <chrono>
 #include <iterator>
+#include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/message.hpp>
+#include <sdbusplus/server/manager.hpp>
+#include <sdeventplus/event.hpp>
 #include <string>
+#include <tuple>
+#include <vector>
 #include <xyz/openbmc_project/Certs/error.hpp>
 #include <xyz/openbmc_project/Common/error.hpp>
 
@@ -15,12 +22,14 @@ namespace
 {
 using InvalidArgument =
     sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+using NotAllowed = sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
 
 class MockCACertMgr : public CACertMgr
 {
   public:
-    MockCACertMgr(sdbusplus::bus_t& bus, const char* path) :
-        CACertMgr(bus, path)
+    MockCACertMgr(sdbusplus::bus_t& bus, sdeventplus::Event& event,
+                  const char* path) :
+        CACertMgr(bus, event, path)
     {
     }
 
@@ -43,6 +52,16 @@ class MockCACertMgr : public CACertMgr
         return entries.size();
     }
 
+    std::string getClientCertificate(uint32_t entryId)
+    {
+        return entries.at(entryId)->clientCertificate();
+    }
+
+    void setClientCertificate(uint32_t entryId, const std::string& cert)
+    {
+        entries.at(entryId)->clientCertificate(cert);
+    }
+
     friend class TestCACertMgr;
 };
 /**
@@ -51,19 +70,22 @@ class MockCACertMgr : public CACertMgr
 class TestCACertMgr : public ::testing::Test
 {
   public:
-    TestCACertMgr() : bus(sdbusplus::bus::new_default())
+    TestCACertMgr() :
+        bus(sdbusplus::bus::new_default()),
+        event(sdeventplus::Event::get_default())
     {
     }
 
   protected:
     sdbusplus::bus_t bus;
+    sdeventplus::Event event;
 };
 
 TEST_F(TestCACertMgr, testObjectCreation)
 {
     auto bus = sdbusplus::bus::new_default();
     std::string objPath = "/xyz/openbmc_project/certs/ca";
-    MockCACertMgr manager(bus, objPath.c_str());
+    MockCACertMgr manager(bus, event, objPath.c_str());
 
     std::string csrString = "csr string";
     EXPECT_NO_THROW(objPath = manager.createCSRObject(csrString));
@@ -74,7 +96,7 @@ TEST_F(TestCACertMgr, testInvalidArgument)
 {
     auto bus = sdbusplus::bus::new_default();
     std::string objPath = "/xyz/openbmc_project/certs/ca";
-    MockCACertMgr manager(bus, objPath.c_str());
+    MockCACertMgr manager(bus, event, objPath.c_str());
 
     std::string csrString(4097, 'C');
 
@@ -85,7 +107,7 @@ TEST_F(TestCACertMgr, DeleteAllCSRObjects)
     auto bus = sdbusplus::bus::new_default();
     std::string objPath = "/xyz/openbmc_project/certs/ca";
 
-    MockCACertMgr manager(bus, objPath.c_str());
+    MockCACertMgr manager(bus, event, objPath.c_str());
 
     std::string csrString = "csr string";
 
@@ -96,12 +118,47 @@ TEST_F(TestCACertMgr, DeleteAllCSRObjects)
 
     EXPECT_TRUE(manager.getNumOfEntries() == 0);
 }
+TEST_F(TestCACertMgr, UnannouncedEntriesAreDeletedSilently)
+{
+    std::string objPath = "/xyz/openbmc_project/certs/ca";
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    // Announced entries would be removed through it
+    sdbusplus::server::manager_t objManager(bus, objPath.c_str());
+    std::vector<std::string> removed;
+    sdbusplus::bus::match_t match(
+        bus, sdbusplus::bus::match::rules::interfacesRemoved(),
+        [&removed, &objPath](sdbusplus::message_t& msg) {
+            sdbusplus::message::object_path path;
+            std::vector<std::string> interfaces;
+            msg.read(path, interfaces);
+            if (path.str.starts_with(objPath))
+            {
+                removed.push_back(path.str);
+            }
+        });
+    MockCACertMgr manager(bus, event, objPath.c_str());
+
+    // The event loop never got idle, so neither entry was announced
+    manager.createCSRObject("first");
+    manager.createCSRObject("second");
+    manager.deleteAll();
+    EXPECT_EQ(manager.getNumOfEntries(), 0);
+
+    auto until = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < until)
+    {
+        event.run(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(removed.empty());
+}
+
 TEST_F(TestCACertMgr, DeleteObjectEntry)
 {
 
     auto bus = sdbusplus::bus::new_default();
     std::string objPath = "/xyz/openbmc_project/certs/ca";
-    MockCACertMgr manager(bus, objPath.c_str());
+    MockCACertMgr manager(bus, event, objPath.c_str());
 
     std::string csrString = "csr string";
     std::string entryPath = manager.createCSRObject(csrString);
@@ -116,5 +173,102 @@ TEST_F(TestCACertMgr, DeleteObjectEntry)
     manager.erase(std::stoi(id));
     EXPECT_TRUE(manager.getNumOfEntries() == 0);
 }
+
+TEST_F(TestCACertMgr, PendingCSRsAreBounded)
+{
+    std::string objPath = "/xyz/openbmc_project/certs/ca";
+    MockCACertMgr manager(bus, event, objPath.c_str());
+
+    for (size_t i = 0; i < maxNumPendingVMICSRs; ++i)
+    {
+        manager.createCSRObject("csr string");
+    }
+    EXPECT_THROW(manager.createCSRObject("csr string"), NotAllowed);
+
+    // Signing one makes room for another
+    auto pending = manager.getPendingCSRs(1);
+    ASSERT_EQ(pending.size(), 1);
+    manager.completeCSRs({{std::get<0>(pending[0]), "certificate"}});
+    EXPECT_NO_THROW(manager.createCSRObject("csr string"));
+    EXPECT_EQ(manager.getNumOfEntries(), maxNumPendingVMICSRs + 1);
+}
+
+TEST_F(TestCACertMgr, PendingCountFollowsEntries)
+{
+    std::string objPath = "/xyz/openbmc_project/certs/ca";
+    MockCACertMgr manager(bus, event, objPath.c_str());
+
+    for (size_t i = 0; i < maxNumPendingVMICSRs; ++i)
+    {
+        manager.createCSRObject("csr string");
+    }
+    EXPECT_THROW(manager.createCSRObject("csr string"), NotAllowed);
+
+    // Deleting a pending entry makes room
+    manager.erase(1);
+    EXPECT_NO_THROW(manager.createCSRObject("csr string"));
+    EXPECT_THROW(manager.createCSRObject("csr string"), NotAllowed);
+
+    // So does setting the certificate property, signed entries don't count
+    manager.setClientCertificate(2, "certificate");
+    manager.erase(2);
+    EXPECT_NO_THROW(manager.createCSRObject("csr string"));
+    EXPECT_THROW(manager.createCSRObject("csr string"), NotAllowed);
+
+    manager.deleteAll();
+    EXPECT_NO_THROW(manager.createCSRObject("csr string"));
+}
+
+TEST_F(TestCACertMgr, PendingCSRsAreHandedOutInBatches)
+{
+    std::string objPath = "/xyz/openbmc_project/certs/ca";
+    MockCACertMgr manager(bus, event, objPath.c_str());
+
+    std::string first = manager.createCSRObject("first");
+    std::string second = manager.createCSRObject("second");
+    std::string third = manager.createCSRObject("third");
+
+    auto pending = manager.getPendingCSRs(2);
+    ASSERT_EQ(pending.size(), 2);
+    EXPECT_EQ(std::get<0>(pending[0]).str, first);
+    EXPECT_EQ(std::get<1>(pending[0]), "first");
+    EXPECT_EQ(std::get<0>(pending[1]).str, second);
+    EXPECT_EQ(manager.getPendingCSRs(0).size(), 3);
+
+    manager.completeCSRs({{first, "first certificate"},
+                          {second, "second certificate"}});
+    pending = manager.getPendingCSRs(0);
+    ASSERT_EQ(pending.size(), 1);
+    EXPECT_EQ(std::get<0>(pending[0]).str, third);
+    EXPECT_EQ(manager.getClientCertificate(1), "first certificate");
+}
+
+TEST_F(TestCACertMgr, InvalidCompletionSetsNoCertificate)
+{
+    std::string objPath = "/xyz/openbmc_project/certs/ca";
+    MockCACertMgr manager(bus, event, objPath.c_str());
+
+    std::string first = manager.createCSRObject("first");
+    std::string second = manager.createCSRObject("second");
+
+    EXPECT_THROW(manager.completeCSRs({{first, "certificate"},
+                                       {objPath + "/entry/3", "certificate"}}),
+                 InvalidArgument);
+    EXPECT_THROW(
+        manager.completeCSRs({{first, "certificate"}, {second, ""}}),
+        InvalidArgument);
+    EXPECT_EQ(manager.getPendingCSRs(0).size(), 2);
+
+    // Also within a batch
+    EXPECT_THROW(manager.completeCSRs({{first, "certificate"},
+                                       {first, "other certificate"}}),
+                 InvalidArgument);
+    EXPECT_EQ(manager.getPendingCSRs(0).size(), 2);
+
+    // Entries are signed once
+    manager.completeCSRs({{first, "certificate"}});
+    EXPECT_THROW(manager.completeCSRs({{first, "certificate"}}),
+                 InvalidArgument);
+}
 } // namespace
 } // namespace ca::cert
@@ -1,16 +1,21 @@
 #include "config.h"
 
+#include "authority_store.hpp"
 #include "certificate.hpp"
 #include "certs_manager.hpp"
 #include "csr.hpp"
+#include "expiry_scheduler.hpp"
+#include "file_utils.hpp"
 
 #include <openssl/bio.h>
 #include <openssl/ossl_typ.h>
 #include <openssl/pem.h>
 #include <openssl/x509.h>
+#include <sys/mman.h>
 #include <systemd/sd-event.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -20,7 +25,9 @@
 #include <iterator>
 #include <memory>
 #include <new>
+#include <optional>
 #include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
 #include <sdeventplus/event.hpp>
 #include <string>
 #include <unordered_set>
@@ -65,6 +72,43 @@ bool compareFiles(const std::string& file1, const std::string& file2)
                       std::istreambuf_iterator<char>(f2.rdbuf()));
 }
 
+// Returns a memfd holding |content|, as a client would pass it
+int createMemfd(const std::string& content)
+{
+    int fd = memfd_create("upload", MFD_CLOEXEC);
+    if (fd == -1 || write(fd, content.data(), content.size()) !=
+                        static_cast<ssize_t>(content.size()))
+    {
+        throw std::bad_alloc();
+    }
+    return fd;
+}
+
+// Runs the event loop until the work deferred to it is done
+void drainEvents(sdeventplus::Event& event)
+{
+    while (event.run(std::chrono::microseconds(0)) > 0)
+    {
+    }
+}
+
+// Replaces every occurrence of |from| with |to| in the file
+void replaceInFile(const fs::path& path, const std::string& from,
+                   const std::string& to)
+{
+    std::ifstream input(path);
+    std::string content((std::istreambuf_iterator<char>(input)),
+                        std::istreambuf_iterator<char>());
+    input.close();
+    for (size_t pos = content.find(from); pos != std::string::npos;
+         pos = content.find(from, pos + to.size()))
+    {
+        content.replace(pos, from.size(), to);
+    }
+    std::ofstream output(path, std::ios::trunc);
+    output << content;
+}
+
 /**
  * Class to generate certificate file and test verification of certificate file
  */
@@ -263,9 +307,46 @@ class ManagerInTest : public phosphor::certs::Manager
     {
     }
 
+    ~ManagerInTest() override
+    {
+        // The owner flushes the batching window, while the mock can still
+        // take the reload
+        flushReload();
+    }
+
     MOCK_METHOD(void, reloadOrReset, (const std::string&), (override));
+
+    using Manager::reindexCertificates;
+};
+
+/** @brief Manager validating the installed certificates on the worker pool,
+ * whatever the async-install option
+ */
+class ManagerWithAsyncInstall : public ManagerInTest
+{
+  public:
+    using ManagerInTest::ManagerInTest;
+
+  protected:
+    bool isInstallAsync() const override
+    {
+        return true;
+    }
 };
 
+// Runs the event loop until the install job at |certObjectPath| finished
+void waitForInstallJob(sdeventplus::Event& event, const Manager& manager,
+                       const std::string& certObjectPath)
+{
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (manager.getInstallJob(certObjectPath) != nullptr &&
+           manager.getInstallJob(certObjectPath)->isInProgress() &&
+           std::chrono::steady_clock::now() < until)
+    {
+        event.run(std::chrono::milliseconds(10));
+    }
+}
+
 /** @brief Check if server install routine is invoked for server setup
  */
 TEST_F(TestCertificates, InvokeServerInstall)
@@ -289,6 +370,129 @@ TEST_F(TestCertificates, InvokeServerInstall)
     EXPECT_TRUE(fs::exists(verifyPath));
 }
 
+/** @brief Check a server certificate installed and replaced from file
+ * descriptors
+ */
+TEST_F(TestCertificates, InstallAndReplaceFromFd)
+{
+    std::string endpoint("https");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return())
+        .WillOnce(Return());
+
+    int fd = createMemfd(readFile(certificateFile));
+    std::string certObjectPath = manager.installFd(fd);
+    close(fd);
+    ASSERT_EQ(manager.getCertificates().size(), 1);
+    EXPECT_EQ(manager.getCertificates().front()->getObjectPath(),
+              certObjectPath);
+    EXPECT_TRUE(compareFiles(installPath, certificateFile));
+
+    // The installed file is written anew
+    fs::remove(installPath);
+    std::string content = readFile(certificateFile);
+    fd = createMemfd(content);
+    manager.replaceCertificateFd(certObjectPath, fd);
+    close(fd);
+    EXPECT_TRUE(compareFiles(installPath, certificateFile));
+
+    using InvalidArgument =
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+    fd = createMemfd(content);
+    EXPECT_THROW(manager.replaceCertificateFd(objPath + "/42", fd),
+                 InvalidArgument);
+    close(fd);
+}
+
+/** @brief Check that a pipe is rejected rather than read on the event loop
+ */
+TEST_F(TestCertificates, PipeUploadIsRejected)
+{
+    std::string endpoint("https");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+
+    using InvalidArgument =
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    std::string content = readFile(certificateFile);
+    ASSERT_EQ(write(fds[1], content.data(), content.size()),
+              static_cast<ssize_t>(content.size()));
+    // The write end stays open, as a sender that never closes it would
+    EXPECT_THROW(manager.installFd(fds[0]), InvalidArgument);
+    close(fds[1]);
+    close(fds[0]);
+    EXPECT_TRUE(manager.getCertificates().empty());
+    EXPECT_FALSE(fs::exists(installPath));
+}
+
+/** @brief Check that a file descriptor holding too much is rejected
+ */
+TEST_F(TestCertificates, TooLargeUploadIsRejected)
+{
+    std::string endpoint("https");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+
+    using NotAllowed =
+        sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
+    std::string content = readFile(certificateFile);
+    content.resize(maxUploadSize + 1, '\n');
+    int fd = createMemfd(content);
+    EXPECT_THROW(manager.installFd(fd), NotAllowed);
+    close(fd);
+    EXPECT_TRUE(manager.getCertificates().empty());
+    EXPECT_FALSE(fs::exists(installPath));
+}
+
+/** @brief Check that the durations of the calls are recorded
+ */
+TEST_F(TestCertificates, InstallDurationIsRecorded)
+{
+    std::string endpoint("https");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return());
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+
+    auto durations = manager.getMetrics().getDurations();
+    EXPECT_EQ(std::get<0>(durations.at("Install")), 1);
+    EXPECT_EQ(std::get<0>(durations.at("DeleteAll")), 0);
+}
+
 /** @brief Check if client install routine is invoked for client setup
  */
 TEST_F(TestCertificates, InvokeClientInstall)
@@ -451,6 +655,111 @@ TEST_F(TestCertificates, InvokeInstallSameCertTwice)
     EXPECT_TRUE(fs::exists(verifyPath));
 }
 
+/** @brief Check an asynchronous install publishes its job right away and
+ * the certificate at the same path once validated.
+ */
+TEST_F(TestCertificates, AsyncInstallCompletesJob)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerWithAsyncInstall manager(bus, event, objPath.c_str(), type,
+                                    verifyUnit, certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+
+    std::string certObjectPath = manager.install(certificateFile);
+    const InstallJob* job = manager.getInstallJob(certObjectPath);
+    ASSERT_NE(job, nullptr);
+    // The result is only published by the event loop
+    EXPECT_TRUE(job->isInProgress());
+    EXPECT_TRUE(manager.getCertificates().empty());
+
+    waitForInstallJob(event, manager, certObjectPath);
+    EXPECT_EQ(job->status(), InstallJob::OperationStatus::Completed);
+    ASSERT_EQ(manager.getCertificates().size(), 1);
+    EXPECT_EQ(manager.getCertificates()[0]->getObjectPath(), certObjectPath);
+    EXPECT_TRUE(fs::exists(certDir + "/" +
+                           getCertSubjectNameHash(certificateFile) + ".0"));
+}
+
+/** @brief Check a certificate failing the validation on the worker pool
+ * fails its job and leaves nothing installed.
+ */
+TEST_F(TestCertificates, AsyncInstallValidationFailureFailsJob)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::client;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerWithAsyncInstall manager(bus, event, objPath.c_str(), type,
+                                    verifyUnit, installPath);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .Times(0);
+
+    // Parses, but lacks the private key the validation requires
+    std::string certOnlyFile = "certonly.pem";
+    ASSERT_EQ(std::system(("openssl x509 -in " + certificateFile + " -out " +
+                           certOnlyFile)
+                              .c_str()),
+              0);
+    std::string certObjectPath = manager.install(certOnlyFile);
+    fs::remove(certOnlyFile);
+    const InstallJob* job = manager.getInstallJob(certObjectPath);
+    ASSERT_NE(job, nullptr);
+
+    waitForInstallJob(event, manager, certObjectPath);
+    EXPECT_EQ(job->status(), InstallJob::OperationStatus::Failed);
+    EXPECT_TRUE(manager.getCertificates().empty());
+    EXPECT_FALSE(fs::exists(installPath));
+}
+
+/** @brief Check that of two asynchronous installs of the same certificate,
+ * both queued before either is validated, only one installs it.
+ */
+TEST_F(TestCertificates, AsyncInstallOfDuplicateFailsLaterJob)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerWithAsyncInstall manager(bus, event, objPath.c_str(), type,
+                                    verifyUnit, certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+
+    // Neither is installed yet, so both pass the check of the request
+    std::string first = manager.install(certificateFile);
+    std::string second = manager.install(certificateFile);
+    ASSERT_NE(first, second);
+    const InstallJob* firstJob = manager.getInstallJob(first);
+    const InstallJob* secondJob = manager.getInstallJob(second);
+    ASSERT_NE(firstJob, nullptr);
+    ASSERT_NE(secondJob, nullptr);
+
+    waitForInstallJob(event, manager, first);
+    waitForInstallJob(event, manager, second);
+    // Whichever is validated last finds the other one installed
+    bool firstWon =
+        firstJob->status() == InstallJob::OperationStatus::Completed;
+    EXPECT_EQ((firstWon ? secondJob : firstJob)->status(),
+              InstallJob::OperationStatus::Failed);
+    ASSERT_EQ(manager.getCertificates().size(), 1);
+    EXPECT_EQ(manager.getCertificates()[0]->getObjectPath(),
+              firstWon ? first : second);
+}
+
 /** @brief Check if in authority mode user can install a certificate with
  * certain subject hash twice.
  */
@@ -493,20 +802,503 @@ TEST_F(TestCertificates, InvokeInstallSameSubjectTwice)
     // Install second certificate
     mainApp.install(certificateFile);
 
-    // Expect there are exactly two certificates in the collection
-    EXPECT_EQ(certs.size(), 2);
-
-    // Check that certificate has been created at installation directory
-    std::string verifyPath1 =
-        verifyDir + "/" + getCertSubjectNameHash(certificateFile) + ".1";
-    EXPECT_TRUE(fs::exists(verifyPath1));
-
-    // Check that installed cert is identical to input one
-    EXPECT_TRUE(compareFiles(certificateFile, verifyPath1));
-
-    // Check that the original/first certificate has been not removed
-    EXPECT_FALSE(fs::is_empty(verifyDir));
-    EXPECT_TRUE(fs::exists(verifyPath0));
+    // Expect there are exactly two certificates in the collection
+    EXPECT_EQ(certs.size(), 2);
+
+    // Check that certificate has been created at installation directory
+    std::string verifyPath1 =
+        verifyDir + "/" + getCertSubjectNameHash(certificateFile) + ".1";
+    EXPECT_TRUE(fs::exists(verifyPath1));
+
+    // Check that installed cert is identical to input one
+    EXPECT_TRUE(compareFiles(certificateFile, verifyPath1));
+
+    // Check that the original/first certificate has been not removed
+    EXPECT_FALSE(fs::is_empty(verifyDir));
+    EXPECT_TRUE(fs::exists(verifyPath0));
+}
+
+/** @brief Check that deleting an authority certificate keeps the symbolic
+ * links of the remaining ones with the same subject consecutive.
+ */
+TEST_F(TestCertificates, DeleteSameSubjectKeepsLinksConsecutive)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyDir(certDir);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    MainApp mainApp(&manager);
+
+    // Install three certificates with the same subject
+    mainApp.install(certificateFile);
+    createNewCertificate();
+    mainApp.install(certificateFile);
+    createNewCertificate();
+    mainApp.install(certificateFile);
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 3);
+
+    std::string verifyPathPrefix =
+        verifyDir + "/" + getCertSubjectNameHash(certificateFile) + ".";
+    EXPECT_TRUE(fs::exists(verifyPathPrefix + "2"));
+
+    // Delete the certificate in the first slot
+    certs[0]->delete_();
+    ASSERT_EQ(certs.size(), 2);
+
+    // The link of the last slot moved into the freed one
+    EXPECT_FALSE(fs::exists(verifyPathPrefix + "2"));
+    ASSERT_TRUE(fs::is_symlink(verifyPathPrefix + "0"));
+    ASSERT_TRUE(fs::is_symlink(verifyPathPrefix + "1"));
+    EXPECT_EQ(fs::read_symlink(verifyPathPrefix + "0"),
+              certs[1]->getCertFilePath());
+    EXPECT_EQ(fs::read_symlink(verifyPathPrefix + "1"),
+              certs[0]->getCertFilePath());
+}
+
+/** @brief Check that changes within the batching window share one reload
+ */
+TEST_F(TestCertificates, ReloadsBatchedWithinWindow)
+{
+    if constexpr (reloadBatchWindowMs == 0)
+    {
+        GTEST_SKIP() << "Reloads aren't batched in this build";
+    }
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          certDir);
+    MainApp mainApp(&manager);
+
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .Times(0);
+    mainApp.install(certificateFile);
+    createNewCertificate(true);
+    mainApp.install(certificateFile);
+    manager.getCertificates()[0]->delete_();
+    ::testing::Mock::VerifyAndClearExpectations(&manager);
+
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .Times(1);
+    auto until = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(reloadBatchWindowMs * 2 + 100);
+    while (std::chrono::steady_clock::now() < until)
+    {
+        event.run(std::chrono::milliseconds(10));
+    }
+    ::testing::Mock::VerifyAndClearExpectations(&manager);
+
+    // Callers needing the reload right away flush the window
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .Times(1);
+    manager.getCertificates()[0]->delete_();
+    manager.flushReload();
+    manager.flushReload();
+
+    // No reload waits for its reply; the mock requests none
+    std::optional<bool> succeeded;
+    manager.waitForReloads([&succeeded](bool s) { succeeded = s; });
+    EXPECT_EQ(succeeded, std::optional<bool>(true));
+}
+
+/** @brief Check that a restart restores unchanged authority certificates
+ * from the store index and validates changed ones again.
+ */
+TEST_F(TestCertificates, RestoreFromStoreIndex)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyDir(certDir);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    createNewCertificate(true);
+    mainApp.install(certificateFile);
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 2);
+    // The installs are written to the index at once, when the loop is idle
+    fs::path indexPath = fs::path(verifyDir) / defaultStoreIndexFileName;
+    EXPECT_FALSE(fs::exists(indexPath));
+    drainEvents(event);
+    ASSERT_TRUE(fs::exists(indexPath));
+
+    // Tell apart the properties restored from the index
+    replaceInFile(indexPath, "O=openbmc-project.xyz", "O=indexed");
+    fs::path changedFile = certs[1]->getCertFilePath();
+    fs::last_write_time(changedFile, fs::last_write_time(changedFile) +
+                                         std::chrono::seconds(1));
+
+    ManagerInTest restarted(bus, event, (objPath + "-restarted").c_str(), type,
+                            verifyUnit, certDir);
+    std::vector<std::unique_ptr<Certificate>>& restored =
+        restarted.getCertificates();
+    ASSERT_EQ(restored.size(), 2);
+    for (const auto& cert : restored)
+    {
+        if (cert->getCertFilePath() == changedFile)
+        {
+            EXPECT_EQ(cert->subject(), certs[1]->subject());
+            EXPECT_EQ(cert->getCertId(), certs[1]->getCertId());
+        }
+        else
+        {
+            EXPECT_EQ(cert->getCertFilePath(), certs[0]->getCertFilePath());
+            EXPECT_EQ(cert->subject(), "O=indexed,CN=localhost");
+            EXPECT_EQ(cert->getCertId(), certs[0]->getCertId());
+        }
+        EXPECT_TRUE(fs::exists(verifyDir + "/" +
+                               getCertSubjectNameHash(cert->getCertFilePath()) +
+                               ".0"));
+    }
+}
+
+/** @brief Check that a certificate expired since it was indexed is validated
+ * again rather than restored, unless expired certificates are allowed.
+ */
+TEST_F(TestCertificates, ExpiredSinceIndexedIsValidatedAgain)
+{
+    if constexpr (allowExpired)
+    {
+        GTEST_SKIP() << "Expired certificates are restored as they are";
+    }
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyDir(certDir);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    drainEvents(event);
+    fs::path indexPath = fs::path(verifyDir) / defaultStoreIndexFileName;
+    ASSERT_TRUE(fs::exists(indexPath));
+
+    // The index claims the certificate expired a second after the epoch
+    uint64_t validNotAfter = manager.getCertificates()[0]->validNotAfter();
+    replaceInFile(indexPath, '\t' + std::to_string(validNotAfter) + '\t',
+                  "\t1\t");
+    replaceInFile(indexPath, "O=openbmc-project.xyz", "O=indexed");
+
+    ManagerInTest restarted(bus, event, (objPath + "-restarted").c_str(), type,
+                            verifyUnit, certDir);
+    std::vector<std::unique_ptr<Certificate>>& restored =
+        restarted.getCertificates();
+    ASSERT_EQ(restored.size(), 1);
+    EXPECT_EQ(restored[0]->validNotAfter(), validNotAfter);
+    EXPECT_NE(restored[0]->subject(), "O=indexed,CN=localhost");
+}
+
+/** @brief Check that the trust store snapshot bundles the authorities and
+ * keeps its generation while they are unchanged.
+ */
+TEST_F(TestCertificates, TrustSnapshotFollowsAuthorities)
+{
+    std::string endpoint("truststore");
+    CertificateType type = CertificateType::authority;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    const TrustSnapshot* snapshot = manager.getTrustSnapshot();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->getGeneration(), 1);
+
+    auto numCertificates = [](const fs::path& path) {
+        std::ifstream stream(path);
+        std::string content((std::istreambuf_iterator<char>(stream)),
+                            std::istreambuf_iterator<char>());
+        size_t count = 0;
+        for (size_t pos = content.find("-----BEGIN CERTIFICATE-----");
+             pos != std::string::npos;
+             pos = content.find("-----BEGIN CERTIFICATE-----", pos + 1))
+        {
+            ++count;
+        }
+        return count;
+    };
+
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    createNewCertificate(true);
+    mainApp.install(certificateFile);
+    ASSERT_EQ(manager.getCertificates().size(), 2);
+    EXPECT_EQ(snapshot->getGeneration(), 3);
+    EXPECT_EQ(numCertificates(snapshot->getPath()), 2);
+    // Only the certificates are bundled, not the keys of the uploads
+    std::ifstream bundle(snapshot->getPath());
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(bundle),
+                          std::istreambuf_iterator<char>())
+                  .find("PRIVATE KEY"),
+              std::string::npos);
+    drainEvents(event);
+
+    // Neither a restart nor the snapshot itself changes the store
+    ManagerInTest restarted(bus, event, (objPath + "-restarted").c_str(),
+                            type, verifyUnit, certDir);
+    EXPECT_CALL(restarted,
+                reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    ASSERT_EQ(restarted.getCertificates().size(), 2);
+    ASSERT_NE(restarted.getTrustSnapshot(), nullptr);
+    EXPECT_EQ(restarted.getTrustSnapshot()->getGeneration(), 3);
+
+    restarted.deleteAll();
+    EXPECT_EQ(restarted.getTrustSnapshot()->getGeneration(), 4);
+    EXPECT_EQ(numCertificates(snapshot->getPath()), 0);
+    EXPECT_TRUE(fs::exists(snapshot->getPath()));
+}
+
+/** @brief Validates the server and client chains against the shared
+ * authorities for the lifetime of the guard, whatever the option
+ */
+class SharedAuthorityStoreEnabled
+{
+  public:
+    SharedAuthorityStoreEnabled() :
+        formerlyEnabled(AuthorityStore::getInstance().isEnabled())
+    {
+        AuthorityStore::getInstance().setEnabled(true);
+    }
+    SharedAuthorityStoreEnabled(const SharedAuthorityStoreEnabled&) = delete;
+    SharedAuthorityStoreEnabled&
+        operator=(const SharedAuthorityStoreEnabled&) = delete;
+    ~SharedAuthorityStoreEnabled()
+    {
+        AuthorityStore::getInstance().setEnabled(formerlyEnabled);
+    }
+
+  private:
+    bool formerlyEnabled;
+};
+
+/** @brief Check that a server certificate not chained to the shared
+ * authorities is rejected, and one issued by them installed.
+ */
+TEST_F(TestCertificates, SharedAuthoritiesRejectUnchainedServerCert)
+{
+    SharedAuthorityStoreEnabled sharedAuthorityStoreEnabled;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    std::string authorityDir(certDir + "/authority");
+    fs::create_directories(authorityDir);
+    auto authorityObjPath =
+        std::string(objectNamePrefix) + '/' +
+        certificateTypeToString(CertificateType::authority) + "/chain";
+    auto serverObjPath =
+        std::string(objectNamePrefix) + '/' +
+        certificateTypeToString(CertificateType::server) + "/chain";
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+
+    // The self-signed certificate of the fixture, with its key
+    std::string selfSignedFile("selfsigned.pem");
+    fs::copy_file(certificateFile, selfSignedFile,
+                  fs::copy_options::overwrite_existing);
+    createNeverExpiredRootCertificate();
+    ASSERT_EQ(std::system("cat demoCA/server.key >> cert.pem"), 0);
+
+    ManagerInTest authorityManager(bus, event, authorityObjPath.c_str(),
+                                   CertificateType::authority, verifyUnit,
+                                   authorityDir);
+    EXPECT_CALL(authorityManager,
+                reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    std::string caFile("demoCA/cacert.pem");
+    authorityManager.install(caFile);
+    ASSERT_EQ(AuthorityStore::getInstance().size(), 1);
+
+    std::string installPath(certDir + "/server.pem");
+    ManagerInTest serverManager(bus, event, serverObjPath.c_str(),
+                                CertificateType::server, verifyUnit,
+                                installPath);
+    EXPECT_CALL(serverManager,
+                reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    EXPECT_THROW(serverManager.install(selfSignedFile), InvalidCertificate);
+    EXPECT_TRUE(serverManager.getCertificates().empty());
+
+    serverManager.install(certificateFile);
+    EXPECT_EQ(serverManager.getCertificates().size(), 1);
+    fs::remove(selfSignedFile);
+}
+
+/** @brief Check that an installed server certificate is restored at
+ * startup even if it isn't chained to the shared authorities.
+ */
+TEST_F(TestCertificates, SharedAuthoritiesRestoreUnchainedServerCert)
+{
+    SharedAuthorityStoreEnabled sharedAuthorityStoreEnabled;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    std::string authorityDir(certDir + "/authority");
+    fs::create_directories(authorityDir);
+    auto authorityObjPath =
+        std::string(objectNamePrefix) + '/' +
+        certificateTypeToString(CertificateType::authority) + "/restore";
+    auto serverObjPath =
+        std::string(objectNamePrefix) + '/' +
+        certificateTypeToString(CertificateType::server) + "/restore";
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+
+    // Installed before the authorities
+    std::string installPath(certDir + "/server.pem");
+    fs::copy_file(certificateFile, installPath);
+    createNeverExpiredRootCertificate();
+
+    ManagerInTest authorityManager(bus, event, authorityObjPath.c_str(),
+                                   CertificateType::authority, verifyUnit,
+                                   authorityDir);
+    EXPECT_CALL(authorityManager,
+                reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    std::string caFile("demoCA/cacert.pem");
+    authorityManager.install(caFile);
+    ASSERT_EQ(AuthorityStore::getInstance().size(), 1);
+
+    ManagerInTest serverManager(bus, event, serverObjPath.c_str(),
+                                CertificateType::server, verifyUnit,
+                                installPath);
+    EXPECT_CALL(serverManager,
+                reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    ASSERT_EQ(serverManager.getCertificates().size(), 1);
+    EXPECT_EQ(serverManager.getCertificates().front()->subject(),
+              "O=openbmc-project.xyz,CN=localhost");
+}
+
+/** @brief Check that a certificate expiring soon is signaled once, however
+ * often the manager indexes its certificates again.
+ */
+TEST_F(TestCertificates, ExpiringSoonSignaledOnceAcrossReindex)
+{
+    std::string endpoint("expiring");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    size_t numExpiringSoon = 0;
+    namespace rules = sdbusplus::bus::match::rules;
+    sdbusplus::bus::match_t match(
+        bus,
+        rules::type::signal() + rules::interface(expiryInterfaceName) +
+            rules::member("ExpiringSoon"),
+        [&numExpiringSoon](sdbusplus::message_t&) { ++numExpiringSoon; });
+    auto runEvents = [&event]() {
+        auto until = std::chrono::steady_clock::now() +
+                     std::chrono::milliseconds(200);
+        while (std::chrono::steady_clock::now() < until)
+        {
+            event.run(std::chrono::milliseconds(10));
+        }
+    };
+
+    ASSERT_EQ(std::system("openssl req -x509 -sha256 -newkey rsa:2048 "
+                          "-keyout cert.pem -out cert.pem -days 1 -nodes "
+                          "-subj /O=openbmc-project.xyz/CN=localhost"),
+              0);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    runEvents();
+    EXPECT_EQ(numExpiringSoon, 1);
+
+    // As InstallAll, ReplaceAll, DeleteAll and the file watch do
+    for (int i = 0; i < 3; ++i)
+    {
+        manager.reindexCertificates();
+        runEvents();
+    }
+    EXPECT_EQ(numExpiringSoon, 1);
+}
+
+/** @brief Check that lazily built properties are built on first read, and
+ * the certificate announced once the event loop is idle.
+ */
+TEST_F(TestCertificates, LazyPropertiesAnnouncedWhenIdle)
+{
+    if constexpr (!lazyProperties)
+    {
+        GTEST_SKIP() << "Built without lazy properties";
+    }
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::authority;
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          certDir);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillRepeatedly(Return());
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    createNewCertificate(true);
+    mainApp.install(certificateFile);
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 2);
+    EXPECT_TRUE(certs[0]->isAnnouncementPending());
+    EXPECT_TRUE(certs[1]->isAnnouncementPending());
+
+    // Reading a property builds it without announcing the certificate
+    EXPECT_EQ(certs[0]->subject(), "O=openbmc-project.xyz,CN=localhost");
+    EXPECT_TRUE(certs[0]->isAnnouncementPending());
+
+    drainEvents(event);
+    EXPECT_FALSE(certs[0]->isAnnouncementPending());
+    EXPECT_FALSE(certs[1]->isAnnouncementPending());
+    EXPECT_THAT(certs[1]->subject(),
+                testing::StartsWith("O=openbmc-project.xyz,CN=localhost"));
+    EXPECT_TRUE(compareFiles(certificateFile, certs[1]->getCertFilePath()));
 }
 
 /** @brief Check if in authority mode user can't install more than
@@ -932,6 +1724,34 @@ TEST_F(TestInvalidCertificate, TestMissingPrivateKey)
     EXPECT_FALSE(fs::exists(verifyPath));
 }
 
+/** @brief Check the existing private key is installed with a certificate file
+ * lacking one, leaving the uploaded file alone
+ */
+TEST_F(TestInvalidCertificate, TestMissingPrivateKeyAppended)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::client;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    fs::copy_file(keyFile, fs::path(certDir) / defaultPrivateKeyFileName);
+    auto uploadSize = fs::file_size(certificateFile);
+
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return());
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+
+    EXPECT_EQ(fs::file_size(certificateFile), uploadSize);
+    std::string installed = readFile(installPath);
+    EXPECT_EQ(installed, readFile(certificateFile) + '\n' + readFile(keyFile));
+}
+
 /** @brief Check install fails if ceritificate is missing in certificate file
  */
 TEST_F(TestInvalidCertificate, TestMissingCeritificate)
@@ -1067,6 +1887,23 @@ TEST_F(TestCertificates, TestGenerateCSR)
     ASSERT_NE("", csrData.c_str());
 }
 
+/** @brief Check the generated CSR is served without reading the CSR file
+ */
+TEST_F(TestCertificates, TestCSRServedFromMemory)
+{
+    std::string csrPath(certDir + "/" + CSRFile);
+    auto objPath = std::string(objectNamePrefix) + "/certs/server/https/csr/1";
+    std::string pem = "-----BEGIN CERTIFICATE REQUEST-----\n";
+    CSR csr(bus, objPath.c_str(), csrPath.c_str(), Status::success,
+            std::string(pem));
+    EXPECT_FALSE(fs::exists(csrPath));
+    EXPECT_EQ(csr.csr(), pem);
+
+    CSR failedCSR(bus, objPath.c_str(), csrPath.c_str(), Status::failure,
+                  std::string(pem));
+    EXPECT_THROW(failedCSR.csr(), InternalFailure);
+}
+
 /** @brief Check if ECC key pair is generated when user is not given algorithm
  * type. At present RSA and EC key pair algorithm are supported
  */
@@ -1305,6 +2142,113 @@ TEST_F(TestCertificates, TestECKeyGeneration)
     EXPECT_TRUE(fs::exists(privateKeyPath));
 }
 
+/** @brief Check that pre-generated EC keys are handed to a single CSR
+ */
+TEST_F(TestCertificates, TestECKeyPoolKeyUsedOnce)
+{
+    std::string endpoint("https");
+    std::string unit;
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string csrPath(certDir + "/" + CSRFile);
+    std::string privateKeyPath(certDir + "/" + privateKeyFile);
+    std::vector<std::string> alternativeNames{"localhost1", "localhost2"};
+    std::string keyCurveId("");
+    std::string keyPairAlgorithm("EC");
+    std::vector<std::string> keyUsage{"serverAuth", "clientAuth"};
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(installPath));
+    Status status;
+    CSR csr(bus, objPath.c_str(), csrPath.c_str(), status);
+    MainApp mainApp(&manager, &csr);
+
+    auto generatePrivateKey = [&]() {
+        // Let the manager pre-generate the key first
+        drainEvents(event);
+        mainApp.generateCSR(alternativeNames, "Password", "BLR", "abc.com",
+                            "Admin", "IN", "admin@in.ibm.com", "givenName",
+                            "G", 2048, keyCurveId, keyPairAlgorithm, keyUsage,
+                            "IBM", "orgUnit", "TS", "surname",
+                            "unstructuredName");
+        for (int i = 0; i < 100 && !fs::exists(csrPath); ++i)
+        {
+            usleep(100000);
+        }
+        EXPECT_TRUE(fs::exists(csrPath));
+        std::ifstream keyFile(privateKeyPath);
+        std::string key((std::istreambuf_iterator<char>(keyFile)),
+                        std::istreambuf_iterator<char>());
+        fs::remove(csrPath);
+        fs::remove(privateKeyPath);
+        return key;
+    };
+
+    std::string firstKey = generatePrivateKey();
+    std::string secondKey = generatePrivateKey();
+    EXPECT_FALSE(firstKey.empty());
+    EXPECT_FALSE(secondKey.empty());
+    EXPECT_NE(firstKey, secondKey);
+}
+
+/** @brief Check concurrent CSRs get their own object and keep their own key
+ */
+TEST_F(TestCertificates, TestConcurrentCSRsKeepTheirKeys)
+{
+    std::string endpoint("https");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    std::vector<std::string> alternativeNames{"localhost1", "localhost2"};
+    std::vector<std::string> keyUsage{"serverAuth", "clientAuth"};
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return());
+    MainApp mainApp(&manager);
+
+    std::vector<fs::path> csrDirs;
+    std::unordered_set<std::string> csrObjectPaths;
+    for (int i = 0; i < 2; ++i)
+    {
+        std::string csrObjectPath = mainApp.generateCSR(
+            alternativeNames, "Password", "BLR", "abc.com", "Admin", "IN",
+            "admin@in.ibm.com", "givenName", "G", 2048, "", "EC", keyUsage,
+            "IBM", "orgUnit", "TS", "surname", "unstructuredName");
+        csrObjectPaths.insert(csrObjectPath);
+        csrDirs.emplace_back(
+            fs::path(certDir) / defaultCSRDirName /
+            csrObjectPath.substr(csrObjectPath.rfind('/') + 1));
+    }
+    EXPECT_EQ(csrObjectPaths.size(), 2);
+
+    // CSRs are generated one at a time
+    fs::path lastCSRFile = csrDirs.back() / defaultCSRFileName;
+    for (int i = 0; i < 100 && !fs::exists(lastCSRFile); ++i)
+    {
+        usleep(100000);
+    }
+    drainEvents(event);
+    ASSERT_TRUE(fs::exists(lastCSRFile));
+    EXPECT_FALSE(compareFiles(csrDirs[0] / defaultPrivateKeyFileName,
+                              csrDirs[1] / defaultPrivateKeyFileName));
+
+    // A certificate for the first CSR finds its key although the default
+    // private key file has the key of the second one
+    std::string cmd = "openssl req -x509 -new -key ";
+    cmd += (csrDirs[0] / defaultPrivateKeyFileName).string();
+    cmd += " -out " + certificateFile + " -days 365000";
+    cmd += " -subj /O=openbmc-project.xyz/CN=localhost";
+    ASSERT_EQ(std::system(cmd.c_str()), 0);
+    mainApp.install(certificateFile);
+    EXPECT_TRUE(fs::exists(installPath));
+}
+
 /** @brief Check error is thrown if giving unsupported key bit length to
  * generate rsa key
  */
@@ -1450,6 +2394,61 @@ TEST_F(TestCertificates, TestRSAKeyFromRSAKeyFileIsWrittenIntoPrivateKeyFile)
     EXPECT_TRUE(fs::exists(privateKeyPath));
 }
 
+/** @brief Check the RSA key is read once and again after its file changed
+ */
+TEST_F(TestCertificates, TestRSAKeyCachedUntilFileChanges)
+{
+    std::string endpoint("https");
+    CertificateType type = CertificateType::server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    std::vector<std::string> alternativeNames{"localhost1", "localhost2"};
+    std::vector<std::string> keyUsage{"serverAuth", "clientAuth"};
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    ManagerInTest manager(bus, event, objPath.c_str(), type, verifyUnit,
+                          installPath);
+    MainApp mainApp(&manager);
+
+    // Returns the private key file of a new RSA CSR
+    auto generateCSR = [&]() {
+        std::string csrObjectPath = mainApp.generateCSR(
+            alternativeNames, "Password", "BLR", "abc.com", "Admin", "IN",
+            "admin@in.ibm.com", "givenName", "G", 2048, "", "RSA", keyUsage,
+            "IBM", "orgUnit", "TS", "surname", "unstructuredName");
+        fs::path csrDir = fs::path(certDir) / defaultCSRDirName /
+                          csrObjectPath.substr(csrObjectPath.rfind('/') + 1);
+        for (int i = 0; i < 100 && !fs::exists(csrDir / defaultCSRFileName);
+             ++i)
+        {
+            usleep(100000);
+        }
+        drainEvents(event);
+        return csrDir / defaultPrivateKeyFileName;
+    };
+
+    fs::path firstKey = generateCSR();
+    ASSERT_TRUE(compareFiles(firstKey, rsaPrivateKeyFilePath));
+
+    // Removing the file doesn't matter once its key was read
+    fs::path savedKeyFile = certDir + "/saved.pem";
+    fs::rename(rsaPrivateKeyFilePath, savedKeyFile);
+    EXPECT_TRUE(compareFiles(generateCSR(), savedKeyFile));
+
+    // A new file is read again
+    std::string cmd = "openssl genrsa -out " + certDir + "/new.pem 2048";
+    ASSERT_EQ(std::system(cmd.c_str()), 0);
+    fs::rename(certDir + "/new.pem", rsaPrivateKeyFilePath);
+    for (int i = 0; i < 5; ++i)
+    {
+        event.run(std::chrono::milliseconds(100));
+    }
+    fs::path lastKey = generateCSR();
+    EXPECT_TRUE(compareFiles(lastKey, rsaPrivateKeyFilePath));
+    EXPECT_FALSE(compareFiles(lastKey, savedKeyFile));
+}
+
 /** @brief Check RSA key is generated during application startup*/
 TEST_F(TestCertificates, TestGenerateRSAPrivateKeyFile)
 {
@@ -1474,10 +2473,8 @@ class AuthoritiesListTest : public testing::Test
   public:
     AuthoritiesListTest() :
         bus(sdbusplus::bus::new_default()),
-        authoritiesListFolder(
-            Certificate::generateUniqueFilePath(fs::temp_directory_path()))
+        authoritiesListFolder(createUniqueDirectory(fs::temp_directory_path()))
     {
-        fs::create_directory(authoritiesListFolder);
         createAuthoritiesList(maxNumAuthorityCertificates);
     }
     ~AuthoritiesListTest() override
@@ -1491,8 +2488,7 @@ class AuthoritiesListTest : public testing::Test
     void createAuthoritiesList(int count)
     {
         fs::path srcFolder = fs::temp_directory_path();
-        srcFolder = Certificate::generateUniqueFilePath(srcFolder);
-        fs::create_directory(srcFolder);
+        srcFolder = createUniqueDirectory(srcFolder);
         createSingleAuthority(srcFolder, "root_0");
         sourceAuthoritiesListFile = srcFolder / "root_0_cert";
         for (int i = 1; i < count; ++i)
@@ -1682,6 +2678,52 @@ TEST_F(AuthoritiesListTest, RecoverAtBootUp)
     EXPECT_TRUE(expectedFiles.empty());
 }
 
+// Tests that the Authority Manager restores an untouched authorities list
+// install from the store index at boot up
+TEST_F(AuthoritiesListTest, RecoverFromStoreIndex)
+{
+    std::string endpoint("ldap");
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    CertificateType type = CertificateType::authority;
+
+    std::string object = std::string(objectNamePrefix) + '/' +
+                         certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, object.c_str(), type, verifyUnit,
+                          authoritiesListFolder);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return());
+    ASSERT_EQ(manager.installAll(sourceAuthoritiesListFile).size(),
+              maxNumAuthorityCertificates);
+    drainEvents(event);
+
+    // Tell apart the properties restored from the index
+    replaceInFile(authoritiesListFolder / defaultStoreIndexFileName,
+                  "O=openbmc-project.xyz", "O=indexed");
+
+    ManagerInTest restarted(bus, event, (object + "-restarted").c_str(), type,
+                            verifyUnit, authoritiesListFolder);
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    std::vector<std::unique_ptr<Certificate>>& restored =
+        restarted.getCertificates();
+    ASSERT_EQ(restored.size(), maxNumAuthorityCertificates);
+    for (size_t i = 0; i < restored.size(); ++i)
+    {
+        EXPECT_EQ(restored[i]->getCertFilePath(), certs[i]->getCertFilePath());
+        EXPECT_EQ(restored[i]->getCertId(), certs[i]->getCertId());
+        std::string subject = certs[i]->subject();
+        EXPECT_EQ(restored[i]->subject(),
+                  subject.replace(0, subject.find(','), "O=indexed"));
+        EXPECT_EQ(restored[i]->certificateString(),
+                  certs[i]->certificateString());
+        EXPECT_TRUE(fs::exists(authoritiesListFolder /
+                               (certs[i]->getCertId().substr(0, 8) + ".0")));
+    }
+}
+
 TEST_F(AuthoritiesListTest, InstallAndDelete)
 {
     std::string endpoint("ldap");
@@ -1711,6 +2753,42 @@ TEST_F(AuthoritiesListTest, InstallAndDelete)
     }
 }
 
+// Tests that uniqueness checks follow single certificate deletions after a
+// bulk install
+TEST_F(AuthoritiesListTest, DeleteOneAndReinstall)
+{
+    std::string endpoint("ldap");
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    CertificateType type = CertificateType::authority;
+
+    std::string object = std::string(objectNamePrefix) + '/' +
+                         certificateTypeToString(type) + '/' + endpoint;
+
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, object.c_str(), type, verifyUnit,
+                          authoritiesListFolder);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return())
+        .WillOnce(Return())
+        .WillOnce(Return());
+    ASSERT_EQ(manager.installAll(sourceAuthoritiesListFile).size(),
+              maxNumAuthorityCertificates);
+
+    fs::path srcFolder = sourceAuthoritiesListFile.parent_path();
+    manager.getCertificates()[1]->delete_();
+    ASSERT_EQ(manager.getCertificates().size(),
+              maxNumAuthorityCertificates - 1);
+
+    // Certificates of the bundle which are still installed stay rejected
+    EXPECT_THROW(manager.install(srcFolder / "root_2_cert"),
+                 sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed);
+    // The deleted one can be installed again
+    EXPECT_NO_THROW(manager.install(srcFolder / "root_1_cert"));
+    EXPECT_EQ(manager.getCertificates().size(), maxNumAuthorityCertificates);
+}
+
 TEST_F(AuthoritiesListTest, InstallAllWrongManagerType)
 {
     std::string endpoint("ldap");
@@ -1824,6 +2902,37 @@ TEST_F(AuthoritiesListTest, CertInWrongFormat)
                  InvalidCertificate);
 }
 
+// Tests that a single malformed certificate in the authorities list fails the
+// whole install before anything is installed
+TEST_F(AuthoritiesListTest, OneCertInWrongFormat)
+{
+    std::string endpoint("ldap");
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    CertificateType type = CertificateType::authority;
+
+    std::string object = std::string(objectNamePrefix) + '/' +
+                         certificateTypeToString(type) + '/' + endpoint;
+
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+
+    ManagerInTest manager(bus, event, object.c_str(), type, verifyUnit,
+                          authoritiesListFolder);
+
+    // Append a non-valid PEM encoded x509 certificate to a valid list
+    createAuthoritiesList(maxNumAuthorityCertificates - 1);
+    {
+        std::ofstream listStream(sourceAuthoritiesListFile, std::ios::app);
+        listStream << "-----BEGIN CERTIFICATE-----\nblah-blah\n"
+                   << "-----END CERTIFICATE-----\n";
+    }
+    EXPECT_THROW(manager.installAll(sourceAuthoritiesListFile),
+                 InvalidCertificate);
+    EXPECT_TRUE(manager.getCertificates().empty());
+    EXPECT_TRUE(fs::is_empty(authoritiesListFolder));
+}
+
 TEST_F(AuthoritiesListTest, ReplaceAll)
 {
     std::string endpoint("ldap");
@@ -1856,5 +2965,83 @@ TEST_F(AuthoritiesListTest, ReplaceAll)
     verifyCertificates(manager.getCertificates());
 }
 
+// Tests that the Authority Manager installs an authorities list passed as a
+// file descriptor
+TEST_F(AuthoritiesListTest, InstallAllFromFd)
+{
+    std::string endpoint("ldap");
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    CertificateType type = CertificateType::authority;
+
+    std::string object = std::string(objectNamePrefix) + '/' +
+                         certificateTypeToString(type) + '/' + endpoint;
+
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, object.c_str(), type, verifyUnit,
+                          authoritiesListFolder);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return())
+        .WillOnce(Return());
+
+    int fd = createMemfd(readFile(sourceAuthoritiesListFile));
+    std::vector<sdbusplus::message::object_path> objects =
+        manager.installAllFd(fd);
+    close(fd);
+    ASSERT_EQ(objects.size(), manager.getCertificates().size());
+    verifyCertificates(manager.getCertificates());
+
+    fd = createMemfd(readFile(sourceAuthoritiesListFile));
+    objects = manager.replaceAllFd(fd);
+    close(fd);
+    for (size_t i = 0; i < manager.getCertificates().size(); ++i)
+    {
+        EXPECT_EQ(manager.getCertificates()[i]->getObjectPath(), objects[i]);
+    }
+    verifyCertificates(manager.getCertificates());
+}
+
+// Tests that a list failing to replace the installed one leaves it untouched
+TEST_F(AuthoritiesListTest, InvalidReplaceAllKeepsCertificates)
+{
+    std::string endpoint("ldap");
+    std::string verifyUnit(ManagerInTest::unitToRestartInTest);
+    CertificateType type = CertificateType::authority;
+
+    std::string object = std::string(objectNamePrefix) + '/' +
+                         certificateTypeToString(type) + '/' + endpoint;
+
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    ManagerInTest manager(bus, event, object.c_str(), type, verifyUnit,
+                          authoritiesListFolder);
+    EXPECT_CALL(manager, reloadOrReset(Eq(ManagerInTest::unitToRestartInTest)))
+        .WillOnce(Return());
+    std::vector<sdbusplus::message::object_path> objects =
+        manager.installAll(sourceAuthoritiesListFile);
+    fs::path installedList = sourceAuthoritiesListFile;
+
+    // Append a non-valid PEM encoded x509 certificate to a valid list
+    createAuthoritiesList(maxNumAuthorityCertificates - 1);
+    {
+        std::ofstream listStream(sourceAuthoritiesListFile, std::ios::app);
+        listStream << "-----BEGIN CERTIFICATE-----\nblah-blah\n"
+                   << "-----END CERTIFICATE-----\n";
+    }
+    EXPECT_THROW(manager.replaceAll(sourceAuthoritiesListFile),
+                 InvalidCertificate);
+
+    ASSERT_EQ(manager.getCertificates().size(), objects.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        EXPECT_EQ(manager.getCertificates()[i]->getObjectPath(), objects[i]);
+    }
+    fs::remove_all(sourceAuthoritiesListFile.parent_path());
+    sourceAuthoritiesListFile = installedList;
+    verifyCertificates(manager.getCertificates());
+}
+
 } // namespace
 } // namespace phosphor::certs
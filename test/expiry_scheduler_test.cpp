@@ -0,0 +1,236 @@
+#include "config.h"
+
+#include "expiry_scheduler.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <sdeventplus/event.hpp>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+using ::testing::_;
+
+constexpr auto managerPath = "/xyz/openbmc_project/certs/server/https";
+constexpr auto certPath = "/xyz/openbmc_project/certs/server/https/1";
+constexpr uint64_t dayToSeconds = 24 * 60 * 60;
+
+class MockExpiryScheduler : public ExpiryScheduler
+{
+  public:
+    using ExpiryScheduler::ExpiryScheduler;
+    using ExpiryScheduler::run;
+
+    MOCK_METHOD(void, notify,
+                (const std::string& objectPath, uint64_t validNotAfter,
+                 bool expired),
+                (override));
+
+    uint64_t getCurrentTime() const override
+    {
+        return fakeNow ? *fakeNow : ExpiryScheduler::getCurrentTime();
+    }
+
+    /** @brief Time the scheduler sees instead of the system clock, if set */
+    std::optional<uint64_t> fakeNow;
+};
+
+uint64_t getCurrentTime()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+}
+
+// Runs the event loop for |duration|
+void runFor(sdeventplus::Event& event, std::chrono::milliseconds duration)
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        event.run(std::chrono::milliseconds(10));
+    }
+}
+
+class TestExpiryScheduler : public ::testing::Test
+{
+  protected:
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    sdeventplus::Event event = sdeventplus::Event::get_default();
+    MockExpiryScheduler scheduler{bus, event, managerPath};
+};
+
+TEST_F(TestExpiryScheduler, ExpiredCertificateIsOnlySignaledExpired)
+{
+    uint64_t validNotAfter = getCurrentTime() - 10;
+    EXPECT_CALL(scheduler, notify(certPath, validNotAfter, true)).Times(1);
+    EXPECT_CALL(scheduler, notify(certPath, validNotAfter, false)).Times(0);
+    scheduler.schedule(certPath, validNotAfter);
+    runFor(event, std::chrono::milliseconds(200));
+}
+
+TEST_F(TestExpiryScheduler, ExpiringSoonThenExpired)
+{
+    uint64_t now = 1700000000;
+    scheduler.fakeNow = now;
+    uint64_t validNotAfter = now + 2 * dayToSeconds;
+    ::testing::InSequence sequence;
+    EXPECT_CALL(scheduler, notify(certPath, validNotAfter, false)).Times(1);
+    EXPECT_CALL(scheduler, notify(certPath, validNotAfter, true)).Times(1);
+    scheduler.schedule(certPath, validNotAfter);
+    scheduler.run();
+    scheduler.fakeNow = validNotAfter - 1;
+    scheduler.run();
+    scheduler.fakeNow = validNotAfter;
+    scheduler.run();
+    scheduler.fakeNow = validNotAfter + dayToSeconds;
+    scheduler.run();
+}
+
+TEST_F(TestExpiryScheduler, RescheduledCertificateIsSignaledOnce)
+{
+    uint64_t now = 1700000000;
+    scheduler.fakeNow = now;
+    uint64_t validNotAfter = now + dayToSeconds;
+    ::testing::InSequence sequence;
+    EXPECT_CALL(scheduler, notify(certPath, validNotAfter, false)).Times(1);
+    EXPECT_CALL(scheduler, notify(certPath, validNotAfter, true)).Times(1);
+    // As a failed replace or an unchanged rewrite of the file does
+    for (int i = 0; i < 100; ++i)
+    {
+        scheduler.unschedule(certPath);
+        scheduler.schedule(certPath, validNotAfter);
+        scheduler.run();
+    }
+    scheduler.fakeNow = validNotAfter;
+    for (int i = 0; i < 100; ++i)
+    {
+        scheduler.schedule(certPath, validNotAfter);
+        scheduler.run();
+    }
+}
+
+TEST_F(TestExpiryScheduler, ClearedAndRescheduledIsSignaledOnce)
+{
+    uint64_t now = 1700000000;
+    scheduler.fakeNow = now;
+    std::string expiredPath = std::string(managerPath) + "/2";
+    EXPECT_CALL(scheduler, notify(certPath, now + dayToSeconds, false))
+        .Times(1);
+    EXPECT_CALL(scheduler, notify(expiredPath, now - 10, true)).Times(1);
+    // As the manager indexing its certificates again does
+    for (int i = 0; i < 10; ++i)
+    {
+        scheduler.clear();
+        scheduler.schedule(certPath, now + dayToSeconds);
+        scheduler.schedule(expiredPath, now - 10);
+        scheduler.run();
+    }
+}
+
+TEST_F(TestExpiryScheduler, NewExpirationIsSignaledAgain)
+{
+    uint64_t now = 1700000000;
+    scheduler.fakeNow = now;
+    EXPECT_CALL(scheduler, notify(certPath, now - 20, true)).Times(1);
+    EXPECT_CALL(scheduler, notify(certPath, now - 10, true)).Times(1);
+    scheduler.schedule(certPath, now - 20);
+    scheduler.run();
+    scheduler.schedule(certPath, now - 10);
+    scheduler.run();
+}
+
+TEST_F(TestExpiryScheduler, DeletedCertificateIsForgotten)
+{
+    uint64_t now = 1700000000;
+    scheduler.fakeNow = now;
+    // A certificate installed again at the path once the former one is gone
+    EXPECT_CALL(scheduler, notify(certPath, now - 10, true)).Times(2);
+    scheduler.schedule(certPath, now - 10);
+    scheduler.run();
+    scheduler.unschedule(certPath);
+    scheduler.run();
+    scheduler.schedule(certPath, now - 10);
+    scheduler.run();
+}
+
+TEST_F(TestExpiryScheduler, FarExpirationIsNotSignaled)
+{
+    EXPECT_CALL(scheduler, notify(_, _, _)).Times(0);
+    uint64_t validNotAfter =
+        getCurrentTime() + (expiryWarningDays + 1) * dayToSeconds;
+    scheduler.schedule(certPath, validNotAfter);
+    runFor(event, std::chrono::milliseconds(200));
+    EXPECT_TRUE(scheduler.getExpiringCertificates().empty());
+}
+
+TEST_F(TestExpiryScheduler, UnscheduledCertificateIsNotSignaled)
+{
+    EXPECT_CALL(scheduler, notify(_, _, _)).Times(0);
+    scheduler.schedule(certPath, getCurrentTime() - 10);
+    scheduler.unschedule(certPath);
+    runFor(event, std::chrono::milliseconds(200));
+    EXPECT_TRUE(scheduler.getExpiringCertificates().empty());
+}
+
+TEST_F(TestExpiryScheduler, ClearedCertificatesAreNotSignaled)
+{
+    EXPECT_CALL(scheduler, notify(_, _, _)).Times(0);
+    scheduler.schedule(certPath, getCurrentTime() - 10);
+    scheduler.schedule(std::string(managerPath) + "/2", getCurrentTime() + 1);
+    scheduler.clear();
+    runFor(event, std::chrono::milliseconds(1500));
+}
+
+TEST_F(TestExpiryScheduler, ReplacedCertificateIsSignaledOnce)
+{
+    uint64_t oldNotAfter = getCurrentTime() - 20;
+    uint64_t newNotAfter = getCurrentTime() - 10;
+    EXPECT_CALL(scheduler, notify(certPath, oldNotAfter, _)).Times(0);
+    EXPECT_CALL(scheduler, notify(certPath, newNotAfter, true)).Times(1);
+    scheduler.schedule(certPath, oldNotAfter);
+    scheduler.schedule(certPath, newNotAfter);
+    runFor(event, std::chrono::milliseconds(200));
+}
+
+TEST_F(TestExpiryScheduler, ManyReplacementsAreCompacted)
+{
+    uint64_t now = getCurrentTime();
+    EXPECT_CALL(scheduler, notify(certPath, now - 1, true)).Times(1);
+    for (uint64_t i = 1000; i > 0; --i)
+    {
+        scheduler.schedule(certPath, now - i);
+    }
+    runFor(event, std::chrono::milliseconds(200));
+}
+
+TEST_F(TestExpiryScheduler, ExpiringCertificatesAreListedEarliestFirst)
+{
+    uint64_t now = getCurrentTime();
+    std::string soonPath = std::string(managerPath) + "/2";
+    std::string farPath = std::string(managerPath) + "/3";
+    EXPECT_CALL(scheduler, notify(_, _, _)).Times(::testing::AnyNumber());
+    scheduler.schedule(soonPath, now + dayToSeconds);
+    scheduler.schedule(certPath, now - dayToSeconds);
+    scheduler.schedule(farPath, now + (expiryWarningDays + 1) * dayToSeconds);
+
+    auto expiring = scheduler.getExpiringCertificates();
+    ASSERT_EQ(expiring.size(), 2);
+    EXPECT_EQ(std::get<0>(expiring[0]).str, certPath);
+    EXPECT_EQ(std::get<1>(expiring[0]), now - dayToSeconds);
+    EXPECT_TRUE(std::get<2>(expiring[0]));
+    EXPECT_EQ(std::get<0>(expiring[1]).str, soonPath);
+    EXPECT_EQ(std::get<1>(expiring[1]), now + dayToSeconds);
+    EXPECT_FALSE(std::get<2>(expiring[1]));
+}
+
+} // namespace
+} // namespace phosphor::certs
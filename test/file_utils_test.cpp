@@ -0,0 +1,142 @@
+#include "file_utils.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+namespace fs = std::filesystem;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+class FileUtilsTest : public ::testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/FakeFiles.XXXXXX";
+        auto dirPtr = mkdtemp(dirTemplate);
+        if (dirPtr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        dir = dirPtr;
+        file = dir / "server.pem";
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir);
+    }
+
+  protected:
+    static std::string contentOf(const fs::path& path)
+    {
+        std::ifstream stream(path);
+        return std::string(std::istreambuf_iterator<char>(stream),
+                           std::istreambuf_iterator<char>());
+    }
+
+    size_t numFiles() const
+    {
+        return static_cast<size_t>(std::distance(fs::directory_iterator(dir),
+                                                 fs::directory_iterator()));
+    }
+
+    fs::path dir;
+    fs::path file;
+};
+
+TEST_F(FileUtilsTest, WriteCreatesTheFile)
+{
+    writeFileAtomically(file, "certificate\n");
+    EXPECT_EQ(contentOf(file), "certificate\n");
+    EXPECT_EQ(readFile(file), "certificate\n");
+    // The temporary file became the file
+    EXPECT_EQ(numFiles(), 1);
+}
+
+TEST_F(FileUtilsTest, WriteReplacesTheFileAndKeepsItsMode)
+{
+    writeFileAtomically(file, "a much longer former certificate\n");
+    fs::permissions(file, fs::perms::owner_read | fs::perms::owner_write);
+    writeFileAtomically(file, "certificate\n");
+    EXPECT_EQ(contentOf(file), "certificate\n");
+    EXPECT_EQ(fs::status(file).permissions(),
+              fs::perms::owner_read | fs::perms::owner_write);
+    EXPECT_EQ(numFiles(), 1);
+}
+
+TEST_F(FileUtilsTest, FailedWriteLeavesNoTemporaryFile)
+{
+    EXPECT_THROW(writeFileAtomically(dir / "missing" / "server.pem", "cert"),
+                 InternalFailure);
+    EXPECT_THROW(readFile(dir / "missing"), InternalFailure);
+    EXPECT_EQ(numFiles(), 0);
+}
+
+TEST_F(FileUtilsTest, ReadsFilesLargerThanAPage)
+{
+    std::string content(100000, 'x');
+    writeFileAtomically(file, content);
+    EXPECT_EQ(readFile(file), content);
+}
+
+TEST_F(FileUtilsTest, ReadsMemfdFromItsStart)
+{
+    int fd = memfd_create("upload", MFD_CLOEXEC);
+    ASSERT_NE(fd, -1);
+    std::string content(100000, 'x');
+    ASSERT_EQ(write(fd, content.data(), content.size()),
+              static_cast<ssize_t>(content.size()));
+    EXPECT_EQ(readFd(fd, 1000000), content);
+    // The offset of the sender is left alone
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), static_cast<off_t>(content.size()));
+    EXPECT_EQ(readFd(fd, content.size()), content);
+    EXPECT_THROW(readFd(fd, content.size() - 1), std::length_error);
+    close(fd);
+}
+
+TEST_F(FileUtilsTest, RejectsPipesInsteadOfBlocking)
+{
+    int fds[2];
+    ASSERT_EQ(pipe2(fds, O_CLOEXEC), 0);
+    std::string content = "certificate";
+    ASSERT_EQ(write(fds[1], content.data(), content.size()),
+              static_cast<ssize_t>(content.size()));
+    // The write end stays open; a read until the end would never return
+    EXPECT_THROW(readFd(fds[0], 1000000), std::invalid_argument);
+    close(fds[1]);
+    close(fds[0]);
+}
+
+TEST_F(FileUtilsTest, UniqueNamesAreReserved)
+{
+    std::string first = createUniqueFile(dir);
+    std::string second = createUniqueFile(dir);
+    EXPECT_NE(first, second);
+    EXPECT_TRUE(fs::is_regular_file(first));
+    EXPECT_TRUE(fs::is_regular_file(second));
+    EXPECT_FALSE(isTemporaryFile(first));
+
+    std::string subdir = createUniqueDirectory(dir);
+    EXPECT_TRUE(fs::is_directory(subdir));
+    EXPECT_TRUE(isTemporaryFile(subdir));
+}
+
+} // namespace
+} // namespace phosphor::certs
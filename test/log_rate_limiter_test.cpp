@@ -0,0 +1,46 @@
+#include "log_rate_limiter.hpp"
+
+#include <chrono>
+#include <optional>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+using namespace std::chrono_literals;
+
+TEST(LogRateLimiterTest, FirstRecordOfEachKeyIsLogged)
+{
+    LogRateLimiter limiter(60s);
+    LogRateLimiter::Clock::time_point now;
+    EXPECT_EQ(limiter.admit(1, now), 0);
+    EXPECT_EQ(limiter.admit(2, now), 0);
+    EXPECT_EQ(limiter.admit(1, now), std::nullopt);
+    EXPECT_EQ(limiter.admit(2, now + 59s), std::nullopt);
+}
+
+TEST(LogRateLimiterTest, SuppressedRecordsAreReportedAfterTheInterval)
+{
+    LogRateLimiter limiter(60s);
+    LogRateLimiter::Clock::time_point now;
+    EXPECT_EQ(limiter.admit(1, now), 0);
+    EXPECT_EQ(limiter.admit(1, now + 10s), std::nullopt);
+    EXPECT_EQ(limiter.admit(1, now + 20s), std::nullopt);
+    EXPECT_EQ(limiter.admit(1, now + 60s), 2);
+    // The interval starts over from the record logged
+    EXPECT_EQ(limiter.admit(1, now + 90s), std::nullopt);
+    EXPECT_EQ(limiter.admit(1, now + 120s), 1);
+}
+
+TEST(LogRateLimiterTest, ZeroIntervalLogsEveryRecord)
+{
+    LogRateLimiter limiter(0s);
+    LogRateLimiter::Clock::time_point now;
+    EXPECT_EQ(limiter.admit(1, now), 0);
+    EXPECT_EQ(limiter.admit(1, now), 0);
+}
+
+} // namespace
+} // namespace phosphor::certs
@@ -0,0 +1,84 @@
+#include "metrics.hpp"
+
+#include <openssl/x509_vfy.h>
+
+#include <chrono>
+#include <cstdint>
+#include <sdbusplus/bus.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+using namespace std::chrono_literals;
+
+constexpr auto metricsPath = "/xyz/openbmc_project/certs/server/metrics";
+
+TEST(Metrics, EveryOperationIsReported)
+{
+    auto bus = sdbusplus::bus::new_default();
+    Metrics metrics(bus, metricsPath);
+    auto durations = metrics.getDurations();
+    EXPECT_EQ(durations.size(), 8);
+    for (const auto& [name, stats] : durations)
+    {
+        EXPECT_EQ(std::get<0>(stats), 0) << name;
+        EXPECT_EQ(std::get<3>(stats).size(),
+                  Metrics::durationBucketBounds.size() + 1)
+            << name;
+    }
+}
+
+TEST(Metrics, DurationsFallIntoTheirBuckets)
+{
+    auto bus = sdbusplus::bus::new_default();
+    Metrics metrics(bus, metricsPath);
+    metrics.record(Operation::install, 50us);
+    metrics.record(Operation::install, 100us);
+    metrics.record(Operation::install, 5ms);
+    metrics.record(Operation::install, 1min);
+
+    auto [count, totalUs, maxUs, buckets] =
+        metrics.getDurations().at("Install");
+    EXPECT_EQ(count, 4);
+    EXPECT_EQ(totalUs, 50 + 100 + 5'000 + 60'000'000);
+    EXPECT_EQ(maxUs, 60'000'000);
+    EXPECT_EQ(buckets, (std::vector<uint64_t>{2, 0, 1, 0, 0, 0, 1}));
+    EXPECT_EQ(std::get<0>(metrics.getDurations().at("InstallAll")), 0);
+}
+
+TEST(Metrics, TimerRecordsTheScope)
+{
+    auto bus = sdbusplus::bus::new_default();
+    Metrics metrics(bus, metricsPath);
+    {
+        Metrics::Timer timer(metrics, Operation::generateCSR);
+        std::this_thread::sleep_for(2ms);
+    }
+    auto [count, totalUs, maxUs, buckets] =
+        metrics.getDurations().at("GenerateCSR");
+    EXPECT_EQ(count, 1);
+    EXPECT_GE(totalUs, 2'000);
+    EXPECT_EQ(maxUs, totalUs);
+}
+
+TEST(Metrics, ValidationFailuresAreCountedByError)
+{
+    auto before = Metrics::getValidationFailures();
+    Metrics::recordValidationFailure(X509_V_ERR_CERT_HAS_EXPIRED);
+    Metrics::recordValidationFailure(X509_V_ERR_CERT_HAS_EXPIRED);
+    Metrics::recordValidationFailure(X509_V_ERR_CERT_SIGNATURE_FAILURE);
+    auto after = Metrics::getValidationFailures();
+    EXPECT_EQ(after[X509_V_ERR_CERT_HAS_EXPIRED],
+              before[X509_V_ERR_CERT_HAS_EXPIRED] + 2);
+    EXPECT_EQ(after[X509_V_ERR_CERT_SIGNATURE_FAILURE],
+              before[X509_V_ERR_CERT_SIGNATURE_FAILURE] + 1);
+}
+
+} // namespace
+} // namespace phosphor::certs
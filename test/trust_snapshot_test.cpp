@@ -0,0 +1,144 @@
+#include "trust_snapshot.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <new>
+#include <sdbusplus/bus.hpp>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+namespace fs = std::filesystem;
+
+constexpr auto managerPath = "/xyz/openbmc_project/certs/authority/truststore";
+
+using Certificates = std::map<std::string, std::string>;
+
+class TrustSnapshotTest : public ::testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/FakeCerts.XXXXXX";
+        auto dirPtr = mkdtemp(dirTemplate);
+        if (dirPtr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        dir = dirPtr;
+        snapshotPath = dir / "certs.bundle.pem";
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir);
+    }
+
+  protected:
+    std::string writeFile(const std::string& name, const std::string& content)
+    {
+        fs::path path = dir / name;
+        std::ofstream stream(path);
+        stream << content;
+        return path;
+    }
+
+    static std::string contentOf(const fs::path& path)
+    {
+        std::ifstream stream(path);
+        return std::string(std::istreambuf_iterator<char>(stream),
+                           std::istreambuf_iterator<char>());
+    }
+
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    fs::path dir;
+    fs::path snapshotPath;
+    // Certificates of the store by file; the files are never written
+    const Certificates::value_type first{"first.pem", "first certificate\n"};
+    const Certificates::value_type second{"second.pem", "second certificate"};
+};
+
+TEST_F(TrustSnapshotTest, BundlesTheCertificatesInFileNameOrder)
+{
+    TrustSnapshot snapshot(bus, managerPath, snapshotPath);
+    EXPECT_EQ(snapshot.getGeneration(), 0);
+    EXPECT_EQ(snapshot.getPath(), snapshotPath);
+    EXPECT_FALSE(fs::exists(snapshotPath));
+
+    snapshot.update(Certificates{second, first});
+    EXPECT_EQ(snapshot.getGeneration(), 1);
+    EXPECT_EQ(contentOf(snapshot.getPath()),
+              "# generation 1\nfirst certificate\nsecond certificate\n");
+}
+
+TEST_F(TrustSnapshotTest, GenerationOnlyChangesWithTheBundle)
+{
+    TrustSnapshot snapshot(bus, managerPath, snapshotPath);
+    snapshot.update(Certificates{first, second});
+    snapshot.update(Certificates{first, second});
+    EXPECT_EQ(snapshot.getGeneration(), 1);
+
+    snapshot.update(Certificates{second});
+    EXPECT_EQ(snapshot.getGeneration(), 2);
+    EXPECT_EQ(contentOf(snapshot.getPath()),
+              "# generation 2\nsecond certificate\n");
+
+    snapshot.update(Certificates{});
+    EXPECT_EQ(snapshot.getGeneration(), 3);
+    EXPECT_EQ(contentOf(snapshot.getPath()), "# generation 3\n");
+}
+
+TEST_F(TrustSnapshotTest, GenerationSurvivesRestarts)
+{
+    {
+        TrustSnapshot snapshot(bus, managerPath, snapshotPath);
+        snapshot.update(Certificates{first});
+        snapshot.update(Certificates{first, second});
+    }
+    TrustSnapshot restarted(bus, managerPath, snapshotPath);
+    EXPECT_EQ(restarted.getGeneration(), 2);
+    restarted.update(Certificates{first, second});
+    EXPECT_EQ(restarted.getGeneration(), 2);
+    restarted.update(Certificates{first});
+    EXPECT_EQ(restarted.getGeneration(), 3);
+}
+
+TEST_F(TrustSnapshotTest, RemovedSnapshotIsWrittenAgain)
+{
+    TrustSnapshot snapshot(bus, managerPath, snapshotPath);
+    snapshot.update(Certificates{first});
+    fs::remove(snapshot.getPath());
+    snapshot.update(Certificates{first});
+    EXPECT_EQ(snapshot.getGeneration(), 2);
+    EXPECT_EQ(contentOf(snapshot.getPath()),
+              "# generation 2\nfirst certificate\n");
+}
+
+TEST_F(TrustSnapshotTest, CorruptedSnapshotStartsOver)
+{
+    writeFile(snapshotPath.filename(), "# generation x\nfirst\n");
+    TrustSnapshot snapshot(bus, managerPath, snapshotPath);
+    EXPECT_EQ(snapshot.getGeneration(), 0);
+    snapshot.update(Certificates{first});
+    EXPECT_EQ(snapshot.getGeneration(), 1);
+}
+
+TEST_F(TrustSnapshotTest, BuiltWithoutReadingTheStore)
+{
+    // The manager holds the certificates; the files aren't read again
+    std::string certFile = writeFile("first.pem", "certificate on flash\n");
+    TrustSnapshot snapshot(bus, managerPath, snapshotPath);
+    snapshot.update(Certificates{{certFile, "first certificate\n"}});
+    EXPECT_EQ(contentOf(snapshot.getPath()),
+              "# generation 1\nfirst certificate\n");
+}
+
+} // namespace
+} // namespace phosphor::certs
@@ -0,0 +1,147 @@
+#include "watch.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sdeventplus/event.hpp>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+namespace fs = std::filesystem;
+
+class WatchTest : public ::testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/FakeWatch.XXXXXX";
+        auto dirPtr = mkdtemp(dirTemplate);
+        if (dirPtr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        watchDir = dirPtr;
+        certFile = (watchDir / "server.pem").string();
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(watchDir);
+    }
+
+  protected:
+    // Writes the file in one go, as each step of a multi-step writer would
+    static void writeFile(const fs::path& path, const std::string& content)
+    {
+        std::ofstream stream(path, std::ios::trunc);
+        stream << content;
+    }
+
+    // Runs the event loop for |duration| at least
+    void runFor(std::chrono::milliseconds duration)
+    {
+        auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until)
+        {
+            event.run(std::chrono::milliseconds(10));
+        }
+    }
+
+    sdeventplus::Event event = sdeventplus::Event::get_default();
+    fs::path watchDir;
+    std::string certFile;
+    size_t numCallbacks = 0;
+};
+
+TEST_F(WatchTest, BurstOfWritesCallsBackOnce)
+{
+    Watch watch(event, certFile, [this]() { ++numCallbacks; });
+    for (int i = 0; i < 5; ++i)
+    {
+        writeFile(certFile, "step " + std::to_string(i));
+    }
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 1);
+
+    writeFile(certFile, "again");
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 2);
+}
+
+TEST_F(WatchTest, OtherFilesAreIgnored)
+{
+    Watch watch(event, certFile, [this]() { ++numCallbacks; });
+    writeFile(watchDir / "other.pem", "other");
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 0);
+}
+
+TEST_F(WatchTest, SuppressionDropsOwnAndPendingChanges)
+{
+    Watch watch(event, certFile, [this]() { ++numCallbacks; });
+    writeFile(certFile, "external");
+    runFor(std::chrono::milliseconds(20));
+    {
+        Watch::Suppression suppression = watch.suppress();
+        {
+            Watch::Suppression nested = watch.suppress();
+            writeFile(certFile, "own");
+        }
+        EXPECT_TRUE(watch.isSuppressed());
+        writeFile(certFile, "own again");
+    }
+    EXPECT_FALSE(watch.isSuppressed());
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 0);
+
+    // The watch keeps going after the suppression
+    writeFile(certFile, "external");
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 1);
+}
+
+TEST_F(WatchTest, RenamedOverFileCallsBack)
+{
+    Watch watch(event, certFile, [this]() { ++numCallbacks; });
+    writeFile(watchDir / "server.pem.tmp", "atomic");
+    fs::rename(watchDir / "server.pem.tmp", certFile);
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 1);
+}
+
+TEST_F(WatchTest, WatchesShareOneDescriptorAndServeSeveralFiles)
+{
+    size_t numOtherCallbacks = 0;
+    Watch watch(event, certFile, [this]() { ++numCallbacks; });
+    watch.addFile((watchDir / "privkey.pem").string());
+    std::string otherFile = (watchDir / "client.pem").string();
+    {
+        Watch other(event, otherFile,
+                    [&numOtherCallbacks]() { ++numOtherCallbacks; });
+        writeFile(watchDir / "privkey.pem", "key");
+        runFor(std::chrono::milliseconds(500));
+        EXPECT_EQ(numCallbacks, 1);
+        EXPECT_EQ(numOtherCallbacks, 0);
+
+        // Suppressing one watch doesn't hide the changes of the other
+        Watch::Suppression suppression = watch.suppress();
+        writeFile(otherFile, "other");
+        runFor(std::chrono::milliseconds(500));
+        EXPECT_EQ(numOtherCallbacks, 1);
+    }
+
+    // The remaining watch still works on the shared directory
+    writeFile(certFile, "cert");
+    runFor(std::chrono::milliseconds(500));
+    EXPECT_EQ(numCallbacks, 2);
+}
+
+} // namespace
+} // namespace phosphor::certs
@@ -0,0 +1,132 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <sdeventplus/event.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace phosphor::certs
+{
+namespace
+{
+
+// Runs the event loop until |count| reaches |expected| or the loop idles for
+// too long
+void runUntil(sdeventplus::Event& event, const size_t& count, size_t expected)
+{
+    for (int i = 0; i < 100 && count < expected; ++i)
+    {
+        event.run(std::chrono::milliseconds(100));
+    }
+}
+
+TEST(WorkerPool, StartsOneThreadPerCpuByDefault)
+{
+    auto event = sdeventplus::Event::get_default();
+    WorkerPool pool(event, 0);
+    EXPECT_EQ(pool.size(), std::max(1U, std::thread::hardware_concurrency()));
+}
+
+TEST(WorkerPool, RunsWorkOffTheLoopAndCompletesOnIt)
+{
+    auto event = sdeventplus::Event::get_default();
+    WorkerPool pool(event, 2);
+    const std::thread::id loopThread = std::this_thread::get_id();
+    constexpr size_t numTasks = 16;
+    std::atomic<size_t> numRunOnLoop = 0;
+    size_t numDone = 0;
+    for (size_t i = 0; i < numTasks; ++i)
+    {
+        pool.submit(
+            [&]() {
+                if (std::this_thread::get_id() == loopThread)
+                {
+                    ++numRunOnLoop;
+                }
+            },
+            [&](std::exception_ptr error) {
+                EXPECT_EQ(error, nullptr);
+                EXPECT_EQ(std::this_thread::get_id(), loopThread);
+                ++numDone;
+            });
+    }
+    runUntil(event, numDone, numTasks);
+    EXPECT_EQ(numDone, numTasks);
+    EXPECT_EQ(numRunOnLoop, 0);
+}
+
+TEST(WorkerPool, HandsExceptionsToCompletion)
+{
+    auto event = sdeventplus::Event::get_default();
+    WorkerPool pool(event, 1);
+    size_t numDone = 0;
+    pool.submit([]() { throw std::runtime_error("validation"); },
+                [&](std::exception_ptr error) {
+                    ASSERT_NE(error, nullptr);
+                    EXPECT_THROW(std::rethrow_exception(error),
+                                 std::runtime_error);
+                    ++numDone;
+                });
+    runUntil(event, numDone, 1);
+    EXPECT_EQ(numDone, 1);
+}
+
+TEST(WorkerPool, CompletionMaySubmitMoreWork)
+{
+    auto event = sdeventplus::Event::get_default();
+    WorkerPool pool(event, 1);
+    size_t numDone = 0;
+    pool.submit([]() {}, [&](std::exception_ptr) {
+        ++numDone;
+        pool.submit([]() {}, [&](std::exception_ptr) { ++numDone; });
+    });
+    runUntil(event, numDone, 2);
+    EXPECT_EQ(numDone, 2);
+}
+
+TEST(WorkerPool, RunAllWaitsForEveryItem)
+{
+    auto event = sdeventplus::Event::get_default();
+    WorkerPool pool(event, 4);
+    constexpr size_t numTasks = 64;
+    std::vector<int> results(numTasks, 0);
+    std::vector<WorkerPool::Work> work;
+    for (size_t i = 0; i < numTasks; ++i)
+    {
+        work.emplace_back(
+            [&results, i]() { results[i] = static_cast<int>(i); });
+    }
+    pool.runAll(std::move(work));
+    for (size_t i = 0; i < numTasks; ++i)
+    {
+        EXPECT_EQ(results[i], static_cast<int>(i));
+    }
+}
+
+TEST(WorkerPool, RunAllRethrowsTheFirstFailure)
+{
+    auto event = sdeventplus::Event::get_default();
+    WorkerPool pool(event, 2);
+    std::atomic<size_t> numRun = 0;
+    std::vector<WorkerPool::Work> work;
+    work.emplace_back([&numRun]() { ++numRun; });
+    work.emplace_back([&numRun]() {
+        ++numRun;
+        throw std::invalid_argument("first");
+    });
+    work.emplace_back([&numRun]() {
+        ++numRun;
+        throw std::runtime_error("second");
+    });
+    EXPECT_THROW(pool.runAll(std::move(work)), std::invalid_argument);
+    EXPECT_EQ(numRun, 3);
+}
+
+} // namespace
+} // namespace phosphor::certs
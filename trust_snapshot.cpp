@@ -0,0 +1,185 @@
+#include "trust_snapshot.hpp"
+
+#include "file_utils.hpp"
+
+#include <charconv>
+#include <exception>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+#include <string_view>
+#include <system_error>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace fs = std::filesystem;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+namespace
+{
+// Start of the first line of the snapshot, followed by the generation
+constexpr std::string_view generationPrefix = "# generation ";
+} // namespace
+
+const sdbusplus::vtable_t TrustSnapshot::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property("Path", "s", TrustSnapshot::getPathProperty,
+                                sdbusplus::vtable::property_::const_),
+    sdbusplus::vtable::property("Generation", "t",
+                                TrustSnapshot::getGenerationProperty,
+                                sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::end()};
+
+TrustSnapshot::TrustSnapshot(sdbusplus::bus_t& bus, const char* path,
+                             const fs::path& snapshotPath) :
+    snapshotPath(snapshotPath),
+    snapshotInterface(bus, path, trustSnapshotInterfaceName, vtable, this)
+{
+    std::error_code ec;
+    if (!fs::exists(snapshotPath, ec))
+    {
+        return;
+    }
+    std::string content;
+    try
+    {
+        content = readFile(snapshotPath);
+    }
+    catch (const InternalFailure& e)
+    {
+        return;
+    }
+
+    // A snapshot without a readable generation is written again
+    std::string_view view(content);
+    size_t lineEnd = view.find('\n');
+    if (!view.starts_with(generationPrefix) || lineEnd == view.npos)
+    {
+        return;
+    }
+    std::string_view number =
+        view.substr(generationPrefix.size(), lineEnd - generationPrefix.size());
+    uint64_t value = 0;
+    auto [end, error] =
+        std::from_chars(number.data(), number.data() + number.size(), value);
+    if (error != std::errc() || end != number.data() + number.size())
+    {
+        return;
+    }
+    generation = value;
+    bundle = view.substr(lineEnd + 1);
+}
+
+void TrustSnapshot::update(
+    const std::map<std::string, std::string>& certificates)
+{
+    // A restart restores the certificates in directory order rather than
+    // in install order; the bundle of an unchanged store must stay the same
+    std::string newBundle;
+    for (const auto& [certFile, pem] : certificates)
+    {
+        newBundle += pem;
+        if (!newBundle.empty() && newBundle.back() != '\n')
+        {
+            newBundle += '\n';
+        }
+    }
+
+    std::error_code ec;
+    if (generation != 0 && newBundle == bundle &&
+        fs::exists(snapshotPath, ec))
+    {
+        return;
+    }
+
+    uint64_t newGeneration = generation + 1;
+    try
+    {
+        writeFileAtomically(snapshotPath,
+                            std::string(generationPrefix) +
+                                std::to_string(newGeneration) + '\n' +
+                                newBundle);
+    }
+    catch (const InternalFailure& e)
+    {
+        // The former snapshot and generation stay consistent
+        return;
+    }
+    bundle = std::move(newBundle);
+    generation = newGeneration;
+    snapshotInterface.property_changed("Generation");
+    log<level::INFO>("Updated trust snapshot",
+                     entry("FILE=%s", snapshotPath.c_str()),
+                     entry("GENERATION=%llu",
+                           static_cast<unsigned long long>(generation)),
+                     entry("NUM=%zu", certificates.size()));
+}
+
+const fs::path& TrustSnapshot::getPath() const
+{
+    return snapshotPath;
+}
+
+uint64_t TrustSnapshot::getGeneration() const
+{
+    return generation;
+}
+
+int TrustSnapshot::getPathProperty(sd_bus* /*bus*/, const char* /*path*/,
+                                   const char* /*interface*/,
+                                   const char* /*property*/,
+                                   sd_bus_message* reply, void* context,
+                                   sd_bus_error* error)
+{
+    auto snapshot = static_cast<TrustSnapshot*>(context);
+    try
+    {
+        sdbusplus::message_t message(reply);
+        message.append(snapshot->getPath().string());
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        // Unwinding through the sd-bus callback would abort the daemon
+        log<level::ERR>("Failed to read the trust snapshot property",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+int TrustSnapshot::getGenerationProperty(sd_bus* /*bus*/,
+                                         const char* /*path*/,
+                                         const char* /*interface*/,
+                                         const char* /*property*/,
+                                         sd_bus_message* reply, void* context,
+                                         sd_bus_error* error)
+{
+    auto snapshot = static_cast<TrustSnapshot*>(context);
+    try
+    {
+        sdbusplus::message_t message(reply);
+        message.append(snapshot->getGeneration());
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to read the trust snapshot property",
+                        entry("ERR=%s", e.what()));
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+} // namespace phosphor::certs
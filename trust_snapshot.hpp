@@ -0,0 +1,91 @@
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <string>
+
+namespace phosphor::certs
+{
+
+/** @brief Interface describing the trust store snapshot of a manager */
+inline constexpr char trustSnapshotInterfaceName[] =
+    "xyz.openbmc_project.Certs.TrustSnapshot";
+
+/** @class TrustSnapshot
+ *
+ *  @brief Single file bundle of the authorities of a store
+ *
+ *  The snapshot concatenates the PEM certificates of the store, in file
+ *  name order, so consumers can load the authorities with a single
+ *  read, as an OpenSSL CAfile, rather than scanning the store directory. It
+ *  is replaced atomically, and its first line holds a generation counter,
+ *  bumped whenever the bundle changes; PEM readers skip it. The interface,
+ *  at the manager object path, has:
+ *  - property Path (s): the snapshot file;
+ *  - property Generation (t): the generation of the snapshot, so consumers
+ *    can skip reloading an unchanged one.
+ */
+class TrustSnapshot
+{
+  public:
+    /** @brief ctor - put the snapshot interface onto the bus, resuming the
+     *  generation of the snapshot left by a former run, if any
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - Path of the manager.
+     *  @param[in] snapshotPath - The snapshot file.
+     */
+    TrustSnapshot(sdbusplus::bus_t& bus, const char* path,
+                  const std::filesystem::path& snapshotPath);
+    TrustSnapshot(const TrustSnapshot&) = delete;
+    TrustSnapshot& operator=(const TrustSnapshot&) = delete;
+    TrustSnapshot(TrustSnapshot&&) = delete;
+    TrustSnapshot& operator=(TrustSnapshot&&) = delete;
+
+    /** @brief Replace the snapshot with the given certificates, unless the
+     *  bundle is unchanged; the snapshot is only derived from the store, so
+     *  failures are logged rather than thrown
+     *  @param[in] certificates - PEM certificates of the store, by file;
+     *                            the files themselves aren't read.
+     */
+    void update(const std::map<std::string, std::string>& certificates);
+
+    /** @brief Get the snapshot file */
+    const std::filesystem::path& getPath() const;
+
+    /** @brief Get the generation of the snapshot; 0 until one is written */
+    uint64_t getGeneration() const;
+
+  private:
+    /** @brief D-Bus property getters of the snapshot interface */
+    static int getPathProperty(sd_bus* bus, const char* path,
+                               const char* interface, const char* property,
+                               sd_bus_message* reply, void* context,
+                               sd_bus_error* error);
+    static int getGenerationProperty(sd_bus* bus, const char* path,
+                                     const char* interface,
+                                     const char* property,
+                                     sd_bus_message* reply, void* context,
+                                     sd_bus_error* error);
+
+    /** @brief Properties of the snapshot interface */
+    static const sdbusplus::vtable_t vtable[];
+
+    /** @brief The snapshot file */
+    std::filesystem::path snapshotPath;
+
+    /** @brief Certificates of the snapshot, without the generation line */
+    std::string bundle;
+
+    /** @brief Generation of the snapshot */
+    uint64_t generation = 0;
+
+    /** @brief The snapshot interface */
+    sdbusplus::server::interface_t snapshotInterface;
+};
+
+} // namespace phosphor::certs
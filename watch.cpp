@@ -4,8 +4,10 @@
 #include <sys/inotify.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
+#include <chrono>
 #include <climits>
 #include <cstdint>
 #include <cstring>
@@ -14,6 +16,9 @@
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdeventplus/source/io.hpp>
+#include <string>
+#include <utility>
+#include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 namespace phosphor::certs
@@ -26,94 +31,256 @@ using ::phosphor::logging::log;
 using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 namespace fs = std::filesystem;
 
-Watch::Watch(sdeventplus::Event& event, std::string& certFile, Callback cb) :
-    event(event), callback(std::move(cb))
+namespace
 {
-    // get parent directory of certificate file to watch
-    fs::path path = fs::path(certFile).parent_path();
-    try
+// Tools may write the certificate in several steps; they're done once the
+// file has been left alone that long
+constexpr std::chrono::milliseconds debounceDelay(100);
+
+// Atomic writers rename a temporary file over the watched one
+constexpr uint32_t watchMask = IN_CLOSE_WRITE | IN_MOVED_TO;
+} // namespace
+
+/** @class InotifyHub
+ *
+ *  @brief The inotify descriptor serving every watch, hooked up with sd-event
+ *  once for the lifetime of the watches
+ */
+class InotifyHub
+{
+  public:
+    explicit InotifyHub(sdeventplus::Event& event)
     {
-        if (!fs::exists(path))
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (-1 == fd)
         {
-            fs::create_directories(path);
+            log<level::ERR>("inotify_init1 failed,",
+                            entry("ERR=%s", std::strerror(errno)));
+            elog<InternalFailure>();
         }
+        ioPtr = std::make_unique<sdeventplus::source::IO>(
+            event, fd, EPOLLIN,
+            [this](sdeventplus::source::IO&, int, uint32_t) { readEvents(); });
     }
-    catch (const fs::filesystem_error& e)
+    InotifyHub(const InotifyHub&) = delete;
+    InotifyHub& operator=(const InotifyHub&) = delete;
+    InotifyHub(InotifyHub&&) = delete;
+    InotifyHub& operator=(InotifyHub&&) = delete;
+
+    ~InotifyHub()
     {
-        log<level::ERR>("Failed to create directory", entry("ERR=%s", e.what()),
-                        entry("DIRECTORY=%s", path.c_str()));
-        elog<InternalFailure>();
+        ioPtr.reset();
+        close(fd);
     }
-    watchDir = path;
-    watchFile = fs::path(certFile).filename();
-    startWatch();
-}
 
-Watch::~Watch()
-{
-    stopWatch();
-}
-
-void Watch::startWatch()
-{
-    // stop any existing watch
-    stopWatch();
+    /** @brief Get the descriptor of the process, opening it if needed; the
+     *  service runs a single event loop
+     */
+    static std::shared_ptr<InotifyHub> get(sdeventplus::Event& event)
+    {
+        static std::weak_ptr<InotifyHub> shared;
+        std::shared_ptr<InotifyHub> hub = shared.lock();
+        if (!hub)
+        {
+            hub = std::make_shared<InotifyHub>(event);
+            shared = hub;
+        }
+        return hub;
+    }
 
-    fd = inotify_init1(IN_NONBLOCK);
-    if (-1 == fd)
+    /** @brief Call |watch| back when |file| changes */
+    void subscribe(Watch& watch, const fs::path& file)
     {
-        log<level::ERR>("inotify_init1 failed,",
-                        entry("ERR=%s", std::strerror(errno)));
-        elog<InternalFailure>();
+        fs::path dir = file.parent_path();
+        // Watching a directory again yields the same watch descriptor
+        int wd = inotify_add_watch(fd, dir.c_str(), watchMask);
+        if (-1 == wd)
+        {
+            log<level::ERR>("inotify_add_watch failed,",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("WATCH=%s", dir.c_str()));
+            elog<InternalFailure>();
+        }
+        subscriptions.push_back({&watch, wd, file.filename()});
     }
-    wd = inotify_add_watch(fd, watchDir.c_str(), IN_CLOSE_WRITE);
-    if (-1 == wd)
+
+    /** @brief Forget every file of |watch| */
+    void unsubscribe(Watch& watch)
     {
-        close(fd);
-        log<level::ERR>("inotify_add_watch failed,",
-                        entry("ERR=%s", std::strerror(errno)),
-                        entry("WATCH=%s", watchDir.c_str()));
-        elog<InternalFailure>();
+        std::vector<int> wds;
+        std::erase_if(subscriptions, [&](const Subscription& subscription) {
+            if (subscription.watch != &watch)
+            {
+                return false;
+            }
+            wds.push_back(subscription.wd);
+            return true;
+        });
+        for (int wd : wds)
+        {
+            if (std::none_of(subscriptions.begin(), subscriptions.end(),
+                             [wd](const Subscription& subscription) {
+                                 return subscription.wd == wd;
+                             }))
+            {
+                inotify_rm_watch(fd, wd);
+            }
+        }
     }
 
-    ioPtr = std::make_unique<sdeventplus::source::IO>(
-        event, fd, EPOLLIN, [this](sdeventplus::source::IO&, int fd, uint32_t) {
-            constexpr int size = sizeof(struct inotify_event) + NAME_MAX + 1;
-            std::array<char, size> buffer{};
-            int length = read(fd, buffer.data(), buffer.size());
-            if (length >= static_cast<int>(sizeof(struct inotify_event)))
+    /** @brief Read every pending event and notify the watches of the files
+     *  that changed; suppressed watches ignore their own changes this way
+     */
+    void readEvents()
+    {
+        alignas(struct inotify_event)
+            std::array<char, 16 * (sizeof(struct inotify_event) + NAME_MAX + 1)>
+                buffer;
+        while (true)
+        {
+            ssize_t length = read(fd, buffer.data(), buffer.size());
+            if (length <= 0)
             {
-                struct inotify_event* notifyEvent =
-                    reinterpret_cast<struct inotify_event*>(&buffer[0]);
-                if (notifyEvent->len)
+                if (length == -1 && errno != EAGAIN)
                 {
-                    if (watchFile == notifyEvent->name)
-                    {
-                        callback();
-                    }
+                    log<level::ERR>("Failed to read inotify event",
+                                    entry("ERR=%s", std::strerror(errno)));
                 }
+                return;
             }
-            else
+            for (ssize_t offset = 0; offset < length;)
             {
-                log<level::ERR>("Failed to read inotify event");
+                auto notifyEvent =
+                    reinterpret_cast<struct inotify_event*>(&buffer[offset]);
+                for (const auto& subscription : subscriptions)
+                {
+                    // Events were dropped on overflow; any file may have
+                    // changed
+                    if ((notifyEvent->mask & IN_Q_OVERFLOW) ||
+                        (notifyEvent->wd == subscription.wd &&
+                         notifyEvent->len &&
+                         subscription.fileName == notifyEvent->name))
+                    {
+                        subscription.watch->changed();
+                    }
+                }
+                offset += sizeof(struct inotify_event) + notifyEvent->len;
             }
-        });
+        }
+    }
+
+  private:
+    struct Subscription
+    {
+        Watch* watch;
+        int wd;
+        std::string fileName;
+    };
+
+    /** @brief inotify file descriptor */
+    int fd = -1;
+
+    /** @brief SDEventPlus IO pointer added to event loop */
+    std::unique_ptr<sdeventplus::source::IO> ioPtr = nullptr;
+
+    /** @brief Watched files */
+    std::vector<Subscription> subscriptions;
+};
+
+Watch::Suppression::Suppression(Watch& watch) : watch(&watch)
+{
+    ++watch.numSuppressions;
 }
 
-void Watch::stopWatch()
+Watch::Suppression::Suppression(Suppression&& other) noexcept :
+    watch(std::exchange(other.watch, nullptr))
+{}
+
+Watch::Suppression& Watch::Suppression::operator=(Suppression&& other) noexcept
 {
-    if (-1 != fd)
+    if (this != &other)
     {
-        if (-1 != wd)
+        if (watch != nullptr)
         {
-            inotify_rm_watch(fd, wd);
+            watch->resume();
         }
-        close(fd);
+        watch = std::exchange(other.watch, nullptr);
     }
-    if (ioPtr)
+    return *this;
+}
+
+Watch::Suppression::~Suppression()
+{
+    if (watch != nullptr)
     {
-        ioPtr.reset();
+        watch->resume();
+    }
+}
+
+Watch::Watch(sdeventplus::Event& event, std::string& certFile, Callback cb) :
+    hub(InotifyHub::get(event)), callback(std::move(cb)),
+    debounceTimer(event, [this](Timer&) { callback(); })
+{
+    addFile(certFile);
+}
+
+Watch::~Watch()
+{
+    hub->unsubscribe(*this);
+}
+
+void Watch::addFile(const std::string& file)
+{
+    // get parent directory of the file to watch
+    fs::path path = fs::path(file).parent_path();
+    try
+    {
+        if (!fs::exists(path))
+        {
+            fs::create_directories(path);
+        }
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        log<level::ERR>("Failed to create directory", entry("ERR=%s", e.what()),
+                        entry("DIRECTORY=%s", path.c_str()));
+        elog<InternalFailure>();
+    }
+    hub->subscribe(*this, file);
+}
+
+Watch::Suppression Watch::suppress()
+{
+    return Suppression(*this);
+}
+
+bool Watch::isSuppressed() const
+{
+    return numSuppressions != 0;
+}
+
+void Watch::changed()
+{
+    if (isSuppressed())
+    {
+        return;
+    }
+    // Every change of the burst pushes the callback further
+    debounceTimer.restartOnce(debounceDelay);
+}
+
+void Watch::resume()
+{
+    if (numSuppressions == 1)
+    {
+        // The events of the changes made meanwhile are queued already; drop
+        // them while still suppressed. Other watches only get their timer
+        // restarted, so nothing calls back from here.
+        hub->readEvents();
+        // Changes seen before are superseded by whoever suppressed them
+        debounceTimer.setEnabled(false);
     }
+    --numSuppressions;
 }
 
 } // namespace phosphor::certs
@@ -1,26 +1,57 @@
 #pragma once
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <sdeventplus/clock.hpp>
 #include <sdeventplus/source/event.hpp>
-#include <sdeventplus/source/io.hpp>
+#include <sdeventplus/utility/timer.hpp>
 #include <string>
 
 namespace phosphor::certs
 {
+class InotifyHub;
+
 /** @class Watch
  *
  *  @brief Adds inotify watch on certificate directory
  *
  *  The inotify watch is hooked up with sd-event, so that on call back,
- *  appropriate actions related to a certificate upload can be taken.
+ *  appropriate actions related to a certificate upload can be taken. A burst
+ *  of changes to the file results in a single call back once it settles.
+ *
+ *  All watches of the process share a single inotify descriptor, which
+ *  lives as long as any watch does.
  */
 class Watch
 {
   public:
     using Callback = std::function<void()>;
+
+    /** @class Suppression
+     *
+     *  @brief Ignores the changes made to the watched files while it lives,
+     *  e.g. while the service replaces the certificate itself
+     */
+    class Suppression
+    {
+      public:
+        /** @brief A suppression of no watch */
+        Suppression() = default;
+        explicit Suppression(Watch& watch);
+        Suppression(const Suppression&) = delete;
+        Suppression& operator=(const Suppression&) = delete;
+        Suppression(Suppression&& other) noexcept;
+        Suppression& operator=(Suppression&& other) noexcept;
+        ~Suppression();
+
+      private:
+        Watch* watch = nullptr;
+    };
+
     /** @brief ctor - hook inotify watch with sd-event
      *
      *  @param[in] loop - sd-event object
+     *  @param[in] certFile - The certificate file to watch
      *  @param[in] cb - The callback function for processing
      *                             certificate upload
      */
@@ -30,41 +61,44 @@ class Watch
     Watch(Watch&&) = delete;
     Watch& operator=(Watch&&) = delete;
 
-    /** @brief dtor - remove inotify watch and close fd's
+    /** @brief dtor - remove inotify watch
      */
     ~Watch();
 
-    /** @brief start watch on the specified path
+    /** @brief Also call back when another file changes, e.g. the private
+     *  key file of the certificate
+     *  @param[in] file - Path of the file to watch
      */
-    void startWatch();
+    void addFile(const std::string& file);
 
-    /** @brief stop watch on the specified path
+    /** @brief Ignore the changes to the watched files until the returned
+     *  suppression goes away; suppressions may nest
      */
-    void stopWatch();
+    [[nodiscard]] Suppression suppress();
+
+    /** @brief Whether changes are currently ignored */
+    bool isSuppressed() const;
 
   private:
-    /** @brief certificate upload directory watch descriptor */
-    int wd = -1;
+    friend class InotifyHub;
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
 
-    /** @brief inotify file descriptor */
-    int fd = -1;
+    /** @brief Called by the inotify descriptor when a watched file changes */
+    void changed();
 
-    /** @brief SDEventPlus IO pointer added to event loop */
-    std::unique_ptr<sdeventplus::source::IO> ioPtr = nullptr;
+    /** @brief End a suppression */
+    void resume();
 
-    /** @brief sd-event object */
-    sdeventplus::Event& event;
+    /** @brief The inotify descriptor shared by all watches */
+    std::shared_ptr<InotifyHub> hub;
 
     /** @brief callback method to be called */
     Callback callback;
 
-    /** @brief Certificate directory to watch */
-    std::string watchDir;
-
-    /** @brief Certificate file to watch */
-    std::string watchFile;
+    /** @brief Calls back once the watched files stop changing */
+    Timer debounceTimer;
 
-    /** @brief Certificate file with path */
-    std::string certFile;
+    /** @brief Number of suppressions alive */
+    size_t numSuppressions = 0;
 };
 } // namespace phosphor::certs
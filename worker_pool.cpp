@@ -0,0 +1,177 @@
+#include "worker_pool.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+WorkerPool::WorkerPool(sdeventplus::Event& event, size_t numThreads)
+{
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == fd)
+    {
+        log<level::ERR>("eventfd failed,",
+                        entry("ERR=%s", std::strerror(errno)));
+        elog<InternalFailure>();
+    }
+
+    ioPtr = std::make_unique<sdeventplus::source::IO>(
+        event, fd, EPOLLIN, [this](sdeventplus::source::IO&, int fd, uint32_t) {
+            uint64_t count = 0;
+            // Only the wakeup matters; every queued completion is dispatched
+            if (read(fd, &count, sizeof(count)) == -1 && errno != EAGAIN)
+            {
+                log<level::ERR>("eventfd read failed,",
+                                entry("ERR=%s", std::strerror(errno)));
+            }
+            dispatchCompleted();
+        });
+
+    if (numThreads == 0)
+    {
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    workers.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    workQueued.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    ioPtr.reset();
+    close(fd);
+}
+
+void WorkerPool::submit(Work work, Done done)
+{
+    {
+        std::lock_guard lock(mutex);
+        pending.push_back({std::move(work), std::move(done)});
+    }
+    workQueued.notify_one();
+}
+
+void WorkerPool::runAll(std::vector<Work> work)
+{
+    Batch batch;
+    batch.remaining = work.size();
+    batch.errors.resize(work.size());
+    {
+        std::lock_guard lock(mutex);
+        for (size_t i = 0; i < work.size(); ++i)
+        {
+            pending.push_back(
+                {std::move(work[i]), nullptr, nullptr, &batch, i});
+        }
+    }
+    workQueued.notify_all();
+
+    std::unique_lock lock(batch.mutex);
+    batch.finished.wait(lock, [&batch]() { return batch.remaining == 0; });
+    for (auto& error : batch.errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+size_t WorkerPool::size() const
+{
+    return workers.size();
+}
+
+void WorkerPool::run()
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock lock(mutex);
+            workQueued.wait(lock,
+                            [this]() { return stopping || !pending.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            task = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        try
+        {
+            task.work();
+        }
+        catch (...)
+        {
+            task.error = std::current_exception();
+        }
+
+        if (task.batch != nullptr)
+        {
+            Batch& batch = *task.batch;
+            std::lock_guard lock(batch.mutex);
+            batch.errors[task.index] = task.error;
+            if (--batch.remaining == 0)
+            {
+                batch.finished.notify_one();
+            }
+            continue;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            completed.push_back(std::move(task));
+        }
+        uint64_t one = 1;
+        if (write(fd, &one, sizeof(one)) == -1)
+        {
+            log<level::ERR>("eventfd write failed,",
+                            entry("ERR=%s", std::strerror(errno)));
+        }
+    }
+}
+
+void WorkerPool::dispatchCompleted()
+{
+    std::deque<Task> finished;
+    {
+        std::lock_guard lock(mutex);
+        finished.swap(completed);
+    }
+    // Completion callbacks may submit more work; the lock isn't held here
+    for (auto& task : finished)
+    {
+        task.done(task.error);
+    }
+}
+} // namespace phosphor::certs
@@ -0,0 +1,124 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace phosphor::certs
+{
+/** @class WorkerPool
+ *
+ *  @brief Runs CPU bound work off the sd-event loop
+ *
+ *  Work items run on a fixed set of threads. Their completion callbacks are
+ *  dispatched back on the sd-event loop through an eventfd, so they can
+ *  safely touch D-Bus objects. Work items themselves must not.
+ */
+class WorkerPool
+{
+  public:
+    using Work = std::function<void()>;
+    using Done = std::function<void(std::exception_ptr)>;
+
+    /** @brief ctor - start the worker threads
+     *
+     *  @param[in] event - sd-event object completions are dispatched on
+     *  @param[in] numThreads - number of worker threads; 0 starts one per
+     *                          CPU
+     */
+    WorkerPool(sdeventplus::Event& event, size_t numThreads);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    /** @brief dtor - join the worker threads; completions which haven't
+     *  been dispatched yet are dropped
+     */
+    ~WorkerPool();
+
+    /** @brief Queue |work| to run on a worker thread
+     *
+     *  @param[in] work - the work to run; exceptions it throws are handed to
+     *                    |done|
+     *  @param[in] done - called on the sd-event loop once |work| finished,
+     *                    with the exception |work| threw if any
+     */
+    void submit(Work work, Done done);
+
+    /** @brief Run every item of |work| on the worker threads and wait until
+     *  all of them finished
+     *
+     *  The caller blocks, so this is meant for bulk work whose result the
+     *  caller needs before it can go on.
+     *
+     *  @param[in] work - the work to run
+     *
+     *  @throw the exception thrown by the first item of |work| that failed;
+     *         the other items still run to completion
+     */
+    void runAll(std::vector<Work> work);
+
+    /** @brief Number of worker threads */
+    size_t size() const;
+
+  private:
+    /** @brief worker thread main loop */
+    void run();
+
+    /** @brief dispatch the finished work items on the sd-event loop */
+    void dispatchCompleted();
+
+    /** @brief Completion state shared by the work items of runAll() */
+    struct Batch
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t remaining = 0;
+        std::vector<std::exception_ptr> errors;
+    };
+
+    /** @brief Work item together with its completion state */
+    struct Task
+    {
+        Work work;
+        Done done;
+        std::exception_ptr error = nullptr;
+        /** @brief set for runAll() items, which complete through it */
+        Batch* batch = nullptr;
+        size_t index = 0;
+    };
+
+    /** @brief protects the queues and |stopping| */
+    std::mutex mutex;
+
+    /** @brief signalled when work is queued or the pool stops */
+    std::condition_variable workQueued;
+
+    /** @brief work waiting for a worker thread */
+    std::deque<Task> pending;
+
+    /** @brief work waiting for its completion to be dispatched */
+    std::deque<Task> completed;
+
+    /** @brief set when the worker threads shall exit */
+    bool stopping = false;
+
+    /** @brief eventfd signalled by the workers on completion */
+    int fd = -1;
+
+    /** @brief SDEventPlus IO pointer added to event loop */
+    std::unique_ptr<sdeventplus::source::IO> ioPtr = nullptr;
+
+    /** @brief worker threads */
+    std::vector<std::thread> workers;
+};
+} // namespace phosphor::certs
@@ -2,18 +2,26 @@
 
 #include "x509_utils.hpp"
 
+#include "log_rate_limiter.hpp"
+#include "metrics.hpp"
+
 #include <openssl/asn1.h>
 #include <openssl/bio.h>
+#include <openssl/buffer.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/ssl3.h>
 #include <openssl/x509_vfy.h>
 
+#include <array>
+#include <chrono>
+#include <climits>
 #include <cstdio>
 #include <ctime>
 #include <exception>
 #include <memory>
+#include <optional>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
@@ -43,6 +51,7 @@ using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
 using BIOMemPtr = std::unique_ptr<BIO, decltype(&::BIO_free)>;
 using ASN1TimePtr = std::unique_ptr<ASN1_TIME, decltype(&ASN1_STRING_free)>;
 using SSLCtxPtr = std::unique_ptr<SSL_CTX, decltype(&::SSL_CTX_free)>;
+using X509StackPtr = std::unique_ptr<STACK_OF(X509), void (*)(STACK_OF(X509)*)>;
 
 // Trust chain related errors.`
 constexpr bool isTrustChainError(int error)
@@ -54,6 +63,101 @@ constexpr bool isTrustChainError(int error)
            error == X509_V_ERR_CERT_UNTRUSTED ||
            error == X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE;
 }
+
+// Validation failures are also counted by Metrics; a bulk install of bad
+// certificates would otherwise flood the journal with the same record
+LogRateLimiter& validationFailureLogs()
+{
+    static LogRateLimiter limiter{
+        std::chrono::seconds(validationErrorLogIntervalSec)};
+    return limiter;
+}
+
+// Verifies |cert| against |x509Store|, with |untrusted| as the intermediate
+// certificates of its chain; trust chain errors are only tolerated if asked
+void verifyCertificate(X509_STORE& x509Store, X509& cert,
+                       STACK_OF(X509) * untrusted, bool allowTrustChainErrors)
+{
+    int errCode = X509_V_OK;
+    X509StoreCtxPtr storeCtx(X509_STORE_CTX_new(), ::X509_STORE_CTX_free);
+    if (!storeCtx)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_CTX_new call");
+        elog<InternalFailure>();
+    }
+
+    errCode = X509_STORE_CTX_init(storeCtx.get(), &x509Store, &cert, untrusted);
+    if (errCode != 1)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_CTX_init call");
+        elog<InternalFailure>();
+    }
+
+    // Set time to current time.
+    auto locTime = time(nullptr);
+
+    X509_STORE_CTX_set_time(storeCtx.get(), X509_V_FLAG_USE_CHECK_TIME,
+                            locTime);
+
+    errCode = X509_verify_cert(storeCtx.get());
+    if (errCode == 1)
+    {
+        errCode = X509_V_OK;
+    }
+    else if (errCode == 0)
+    {
+        errCode = X509_STORE_CTX_get_error(storeCtx.get());
+        log<level::DEBUG>(
+            "Error occurred during X509_verify_cert call, checking for known "
+            "error",
+            entry("ERRCODE=%d", errCode),
+            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
+    }
+    else
+    {
+        log<level::ERR>("Error occurred during X509_verify_cert call");
+        elog<InternalFailure>();
+    }
+
+    // Allow certificate upload, for "certificate is not yet valid" and,
+    // unless the chain is checked, trust chain related errors.
+    // If ALLOW_EXPIRED is defined, allow expired certificate so that it
+    // could be replaced
+    bool isOK = (errCode == X509_V_OK) ||
+                (errCode == X509_V_ERR_CERT_NOT_YET_VALID) ||
+                (allowTrustChainErrors && isTrustChainError(errCode)) ||
+                (allowExpired && errCode == X509_V_ERR_CERT_HAS_EXPIRED);
+
+    if (!isOK)
+    {
+        Metrics::recordValidationFailure(errCode);
+        std::optional<size_t> suppressed =
+            validationFailureLogs().admit(errCode);
+        if (errCode == X509_V_ERR_CERT_HAS_EXPIRED)
+        {
+            if (suppressed)
+            {
+                log<level::ERR>("Expired certificate ",
+                                entry("SUPPRESSED=%zu", *suppressed));
+            }
+            elog<InvalidCertificate>(Reason("Expired Certificate"));
+        }
+        // Loging general error here.
+        if (suppressed)
+        {
+            log<level::ERR>(
+                "Certificate validation failed", entry("ERRCODE=%d", errCode),
+                entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)),
+                entry("SUPPRESSED=%zu", *suppressed));
+        }
+        elog<InvalidCertificate>(Reason("Certificate validation failed"));
+    }
+}
+
+// PEM certificate block markers, defined in go/rfc/7468.
+constexpr std::string_view beginCertificate = "-----BEGIN CERTIFICATE-----";
+constexpr std::string_view endCertificate = "-----END CERTIFICATE-----";
+
 } // namespace
 
 X509StorePtr getX509Store(const std::string& certSrcPath)
@@ -89,6 +193,30 @@ X509StorePtr getX509Store(const std::string& certSrcPath)
     return x509Store;
 }
 
+X509StorePtr getX509Store(const std::vector<X509Ptr>& certs)
+{
+    X509StorePtr x509Store(X509_STORE_new(), &X509_STORE_free);
+    if (!x509Store)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_new call");
+        elog<InternalFailure>();
+    }
+
+    OpenSSL_add_all_algorithms();
+
+    for (const auto& cert : certs)
+    {
+        // The store takes its own reference of the certificate.
+        if (X509_STORE_add_cert(x509Store.get(), cert.get()) != 1)
+        {
+            log<level::ERR>("Error occurred during X509_STORE_add_cert call",
+                            entry("ERRCODE=%lu", ERR_get_error()));
+            elog<InvalidCertificate>(Reason("Invalid certificate file format"));
+        }
+    }
+    return x509Store;
+}
+
 X509Ptr loadCert(const std::string& filePath)
 {
     // Read Certificate file
@@ -143,75 +271,49 @@ void validateCertificateStartDate(X509& cert)
 
 void validateCertificateAgainstStore(X509_STORE& x509Store, X509& cert)
 {
-    int errCode = X509_V_OK;
-    X509StoreCtxPtr storeCtx(X509_STORE_CTX_new(), ::X509_STORE_CTX_free);
-    if (!storeCtx)
-    {
-        log<level::ERR>("Error occurred during X509_STORE_CTX_new call");
-        elog<InternalFailure>();
-    }
-
-    errCode = X509_STORE_CTX_init(storeCtx.get(), &x509Store, &cert, nullptr);
-    if (errCode != 1)
-    {
-        log<level::ERR>("Error occurred during X509_STORE_CTX_init call");
-        elog<InternalFailure>();
-    }
-
-    // Set time to current time.
-    auto locTime = time(nullptr);
-
-    X509_STORE_CTX_set_time(storeCtx.get(), X509_V_FLAG_USE_CHECK_TIME,
-                            locTime);
+    verifyCertificate(x509Store, cert, nullptr,
+                      /*allowTrustChainErrors=*/true);
+}
 
-    errCode = X509_verify_cert(storeCtx.get());
-    if (errCode == 1)
-    {
-        errCode = X509_V_OK;
-    }
-    else if (errCode == 0)
-    {
-        errCode = X509_STORE_CTX_get_error(storeCtx.get());
-        log<level::INFO>(
-            "Error occurred during X509_verify_cert call, checking for known "
-            "error",
-            entry("ERRCODE=%d", errCode),
-            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
-    }
-    else
+void validateCertificateChain(X509_STORE& x509Store, X509& cert,
+                              const std::vector<X509Ptr>& untrusted)
+{
+    X509StackPtr chain(sk_X509_new_null(),
+                       [](STACK_OF(X509) * stack) { sk_X509_free(stack); });
+    if (!chain)
     {
-        log<level::ERR>("Error occurred during X509_verify_cert call");
+        log<level::ERR>("Error occurred during sk_X509_new_null call");
         elog<InternalFailure>();
     }
-
-    // Allow certificate upload, for "certificate is not yet valid" and
-    // trust chain related errors.
-    // If ALLOW_EXPIRED is defined, allow expired certificate so that it
-    // could be replaced
-    bool isOK = (errCode == X509_V_OK) ||
-                (errCode == X509_V_ERR_CERT_NOT_YET_VALID) ||
-                isTrustChainError(errCode) ||
-                (allowExpired && errCode == X509_V_ERR_CERT_HAS_EXPIRED);
-
-    if (!isOK)
+    for (const auto& intermediate : untrusted)
     {
-        if (errCode == X509_V_ERR_CERT_HAS_EXPIRED)
+        // The stack doesn't own the certificates
+        if (intermediate && sk_X509_push(chain.get(), intermediate.get()) == 0)
         {
-            log<level::ERR>("Expired certificate ");
-            elog<InvalidCertificate>(Reason("Expired Certificate"));
+            log<level::ERR>("Error occurred during sk_X509_push call");
+            elog<InternalFailure>();
         }
-        // Loging general error here.
-        log<level::ERR>(
-            "Certificate validation failed", entry("ERRCODE=%d", errCode),
-            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
-        elog<InvalidCertificate>(Reason("Certificate validation failed"));
     }
+    verifyCertificate(x509Store, cert, chain.get(),
+                      /*allowTrustChainErrors=*/false);
 }
 
 void validateCertificateInSSLContext(X509& cert)
 {
-    const SSL_METHOD* method = TLS_method();
-    SSLCtxPtr ctx(SSL_CTX_new(method), SSL_CTX_free);
+    // Building an SSL_CTX is expensive under OpenSSL 3 (provider and config
+    // loading), so every thread keeps its own one around. Using a certificate
+    // mutates the context, hence it isn't shared across threads.
+    thread_local SSLCtxPtr ctx(nullptr, SSL_CTX_free);
+    if (!ctx)
+    {
+        ctx.reset(SSL_CTX_new(TLS_method()));
+        if (!ctx)
+        {
+            log<level::ERR>("Error occurred during SSL_CTX_new call",
+                            entry("ERRCODE=%lu", ERR_get_error()));
+            elog<InternalFailure>();
+        }
+    }
     if (SSL_CTX_use_certificate(ctx.get(), &cert) != 1)
     {
         log<level::ERR>("Certificate is not usable",
@@ -233,7 +335,54 @@ std::string generateCertId(X509& cert)
     return {idBuff};
 }
 
-std::unique_ptr<X509, decltype(&::X509_free)> parseCert(const std::string& pem)
+std::string generateSubjectNameHash(X509& cert)
+{
+    unsigned long hash = X509_subject_name_hash(&cert);
+    static constexpr auto certHashLength = 9;
+    char hashBuf[certHashLength];
+
+    snprintf(hashBuf, certHashLength, "%08lx", hash);
+
+    return {hashBuf};
+}
+
+std::string generateFingerprint(X509& cert)
+{
+    std::array<unsigned char, EVP_MAX_MD_SIZE> digest{};
+    unsigned int digestLength = 0;
+    if (!X509_digest(&cert, EVP_sha256(), digest.data(), &digestLength))
+    {
+        log<level::ERR>("Error occurred during X509_digest call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+
+    static constexpr std::string_view hexDigits = "0123456789abcdef";
+    std::string fingerprint;
+    fingerprint.reserve(digestLength * 2);
+    for (unsigned int i = 0; i < digestLength; ++i)
+    {
+        fingerprint.push_back(hexDigits[digest[i] >> 4]);
+        fingerprint.push_back(hexDigits[digest[i] & 0x0f]);
+    }
+    return fingerprint;
+}
+
+std::string encodeCert(X509& cert)
+{
+    BIOMemPtr certBio(BIO_new(BIO_s_mem()), BIO_free);
+    if (!certBio || PEM_write_bio_X509(certBio.get(), &cert) != 1)
+    {
+        log<level::ERR>("Error occurred during PEM_write_bio_X509 call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+    BUF_MEM* buf = nullptr;
+    BIO_get_mem_ptr(certBio.get(), &buf);
+    return {buf->data, buf->length};
+}
+
+std::unique_ptr<X509, decltype(&::X509_free)> parseCert(std::string_view pem)
 {
     if (pem.size() > INT_MAX)
     {
@@ -254,9 +403,73 @@ std::unique_ptr<X509, decltype(&::X509_free)> parseCert(const std::string& pem)
     if (!PEM_read_bio_X509(bioCert.get(), &x509, nullptr, nullptr))
     {
         log<level::ERR>("Error occurred during PEM_read_bio_X509 call",
-                        entry("PEM=%s", pem.c_str()));
-        elog<InternalFailure>();
+                        entry("SIZE=%zu", pem.size()));
+        if constexpr (logCertificatePem)
+        {
+            log<level::DEBUG>("Certificate failing to parse",
+                              entry("PEM=%.*s", static_cast<int>(pem.size()),
+                                    pem.data()));
+        }
+        elog<InvalidCertificate>(Reason("Invalid certificate file format"));
     }
     return cert;
 }
+
+std::vector<X509Ptr> parseCerts(std::string_view pem)
+{
+    if (pem.size() > INT_MAX)
+    {
+        log<level::ERR>("Error occurred during parseCerts: PEM is too long");
+        elog<InvalidCertificate>(Reason("Invalid PEM: too long"));
+    }
+    BIOMemPtr bio(BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size())),
+                  ::BIO_free);
+    if (!bio)
+    {
+        log<level::ERR>("Error occurred during BIO_new_mem_buf call");
+        elog<InternalFailure>();
+    }
+
+    std::vector<X509Ptr> certs;
+    while (X509* x509 = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr))
+    {
+        certs.emplace_back(x509, ::X509_free);
+    }
+    // The end of the buffer is reported as an error too
+    ERR_clear_error();
+    if (certs.empty())
+    {
+        log<level::ERR>("No certificate found in the PEM");
+        elog<InvalidCertificate>(Reason("Invalid certificate file format"));
+    }
+    return certs;
+}
+
+std::vector<std::string_view> splitCertificates(std::string_view pem)
+{
+    std::vector<std::string_view> certificatesList;
+    size_t begin = 0;
+    // |begin| points to the current start position for searching the next
+    // |beginCertificate| block. When we find the beginning of the certificate,
+    // we extract the content between the beginning and the end of the current
+    // certificate. And finally we move |begin| to the end of the current
+    // certificate to start searching the next potential certificate.
+    for (begin = pem.find(beginCertificate, begin);
+         begin != std::string_view::npos;
+         begin = pem.find(beginCertificate, begin))
+    {
+        size_t end = pem.find(endCertificate, begin);
+        if (end == std::string_view::npos)
+        {
+            log<level::ERR>(
+                "invalid PEM contains a BEGIN identifier without an END");
+            elog<InvalidCertificate>(Reason(
+                "invalid PEM contains a BEGIN identifier without an END"));
+        }
+        end += endCertificate.size();
+        certificatesList.emplace_back(pem.substr(begin, end - begin));
+        begin = end;
+    }
+    return certificatesList;
+}
 } // namespace phosphor::certs
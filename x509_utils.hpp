@@ -4,6 +4,8 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace phosphor::certs
 {
@@ -17,6 +19,16 @@ namespace phosphor::certs
 std::unique_ptr<X509_STORE, decltype(&::X509_STORE_free)>
     getX509Store(const std::string& certSrcPath);
 
+/** @brief Creates an X509 Store from already parsed certificates
+ *  Creates an X509 Store and adds each of the given certificates to it, so
+ * that callers which already decoded the certificates don't have to read
+ * and parse the source file again
+ *  @param[in] certs - the trusted certificates
+ *
+ */
+std::unique_ptr<X509_STORE, decltype(&::X509_STORE_free)> getX509Store(
+    const std::vector<std::unique_ptr<X509, decltype(&::X509_free)>>& certs);
+
 /** @brief Loads Certificate file into the X509 structure.
  *  @param[in] filePath - Certificate and key full file path.
  *  @return pointer to the X509 structure.
@@ -41,9 +53,28 @@ void validateCertificateStartDate(X509& cert);
  */
 void validateCertificateAgainstStore(X509_STORE& x509Store, X509& cert);
 
+/**
+ * @brief Validates the certificate chains up to one of the trusted
+ * certificates of the store and throws error otherwise; unlike
+ * validateCertificateAgainstStore(), trust chain errors aren't tolerated
+ * Concurrent calls sharing the same store are safe.
+ * @param[in] x509Store Reference to trusted certificates store
+ * @param[in] cert Reference to certificate to be validated
+ * @param[in] untrusted Intermediate certificates that may complete the
+ * chain, e.g. the other certificates of the uploaded file; null ones are
+ * skipped
+ * @return void
+ */
+void validateCertificateChain(
+    X509_STORE& x509Store, X509& cert,
+    const std::vector<std::unique_ptr<X509, decltype(&::X509_free)>>&
+        untrusted);
+
 /**
  * @brief Validates the certificate can be used in an SSL context, otherwise,
  * throws errors
+ * The context is created once per thread and reused, so it is safe to call
+ * from the worker threads.
  * @param[in] cert Reference to certificate to be validated
  * @return void
  */
@@ -58,9 +89,53 @@ void validateCertificateInSSLContext(X509& cert);
  */
 std::string generateCertId(X509& cert);
 
+/**
+ * @brief Generates the subject name hash used by OpenSSL to look up
+ * certificates in a hashed directory.
+ *
+ * @param[in] cert - Certificate object.
+ *
+ * @return Subject name hash as formatted string.
+ */
+std::string generateSubjectNameHash(X509& cert);
+
+/**
+ * @brief Generates the SHA-256 fingerprint of the provided certificate.
+ *
+ * @param[in] cert - Certificate object.
+ *
+ * @return Fingerprint as a lowercase hex string.
+ */
+std::string generateFingerprint(X509& cert);
+
+/**
+ * @brief Encodes the provided certificate alone in PEM format.
+ *
+ * @param[in] cert - Certificate object.
+ *
+ * @return PEM encoded certificate.
+ */
+std::string encodeCert(X509& cert);
+
 /** @brief Parses PEM string into the X509 structure.
  *  @param[in] pem - PEM encoded X509 certificate buffer.
  *  @return pointer to the X509 structure.
  */
-std::unique_ptr<X509, decltype(&::X509_free)> parseCert(const std::string& pem);
+std::unique_ptr<X509, decltype(&::X509_free)> parseCert(std::string_view pem);
+
+/** @brief Parses every certificate of the PEM string, in order; the other
+ * PEM blocks, e.g. a private key, are skipped
+ *  @param[in] pem - PEM encoded buffer, e.g. a certificate file.
+ *  @return the X509 structures; there is at least one.
+ */
+std::vector<std::unique_ptr<X509, decltype(&::X509_free)>>
+    parseCerts(std::string_view pem);
+
+/** @brief Splits the given authorities list into the individual PEM encoded
+ * x509 certificates; no certificate is copied, the returned views point into
+ * |pem|
+ *  @param[in] pem - Content of the authorities list.
+ *  @return the PEM encoded certificates, in order
+ */
+std::vector<std::string_view> splitCertificates(std::string_view pem);
 } // namespace phosphor::certs